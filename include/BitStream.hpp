@@ -1,50 +1,120 @@
 #ifndef BITSTREAM_HPP
 #define BITSTREAM_HPP
 
+#include "ByteSpan.hpp"
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <cstring>
+#include <stdexcept>
 
 namespace huffman {
 
+// 以大端序读写 64 位整数（允许非对齐地址）
+inline uint64_t loadBigEndian64(const uint8_t* src) {
+    uint64_t value;
+    std::memcpy(&value, src, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+inline void storeBigEndian64(uint8_t* dest, uint64_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    std::memcpy(dest, &value, sizeof(value));
+}
+
 class BitOutputStream {
 private:
-    std::vector<uint8_t> buffer; // 字节缓冲区
-    uint8_t currentByte;         // 当前正在写入的字节
-    int bitCount;                // 当前字节中已写入的位数
+    std::vector<uint8_t> buffer; // 字节缓冲区，尾部至少预留 8 字节供整字写入
+    size_t byteCount;            // 已写入缓冲区的字节数
+    uint64_t bitBuffer;          // 位累加器，低 bitCount 位有效
+    unsigned bitCount;           // 累加器中的位数
+
+    // 累加器写满 64 位时整字写入缓冲区
+    void storeWord(uint64_t word);
+
+    // 把累加器中的完整字节写入缓冲区
+    void drainBytes();
 
 public:
     BitOutputStream();
+    // 接管已有数据，在其后继续写入
+    explicit BitOutputStream(std::vector<uint8_t>&& prefix);
     ~BitOutputStream();
 
     void writeBit(bool bit);
-    void writeBits(std::vector<bool> bits);
+    void writeBits(const std::vector<bool>& bits);
+    // 写入 bits 的低 length 位（高位先写），要求 length < 64 且更高位为 0
+    inline void writeBits(uint64_t bits, unsigned length);
 
     void writeByte(uint8_t byte);
-    void writeBytes(std::vector<uint8_t> bytes);
+    void writeBytes(const std::vector<uint8_t>& bytes);
+    void writeBytes(const uint8_t* data, size_t size);
 
     void flush();
     void clear();
+    // 预留 bytes 字节的缓冲区
+    void reserve(size_t bytes);
+
+    // 由外部代码直接整字写入：返回写入位置，其后至少可写 maxBytes 字节，
+    // 并取出累加器；写完后调用 endDirect 提交写入的字节数和新的累加器
+    uint8_t* beginDirect(size_t maxBytes, uint64_t& bits, unsigned& count);
+    void endDirect(size_t bytes, uint64_t bits, unsigned count);
 
     std::vector<uint8_t> getBuffer() const;
-    int getBitCount() const;
+    // 补齐最后一个字节并取走缓冲区
+    std::vector<uint8_t> takeBuffer();
+    size_t getBitCount() const;
     void writeToFile(const std::string& filename);
 };
 
+// 热路径，定义在头文件中以便内联
+inline void BitOutputStream::writeBits(uint64_t bits, unsigned length) {
+    if (bitCount + length < 64) {
+        bitBuffer = (bitBuffer << length) | bits;
+        bitCount += length;
+        return;
+    }
+
+    // 先用 bits 的高位补满 64 位整字写出，剩余低位留在累加器中
+    unsigned rest = bitCount + length - 64;
+    storeWord((bitBuffer << (64 - bitCount)) | (bits >> rest));
+    bitBuffer = bits;
+    bitCount = rest;
+}
+
+
+constexpr unsigned MIN_REFILL_BITS = 57; // 每次补充后位容器中至少可用的位数
 
+// 位输入流，读取借用的字节视图，不复制数据
 class BitInputStream {
 private:
-    std::vector<uint8_t> buffer; // 字节缓冲区
-    uint32_t byteIndex;          // 当前字节序列的索引
-    uint8_t bitIndex;            // 当前位在字节中的索引
+    std::vector<uint8_t> ownedBuffer; // 从文件加载时持有的数据
+    const uint8_t* data;              // 数据起始地址
+    size_t dataSize;                  // 数据的字节数
+    size_t bitPosition;               // 已读取的位数
+    uint64_t bitContainer;       // 从当前位置起的位，左对齐
+    unsigned containerBits;      // 位容器中可用的位数
+
+    // 保证位容器中至少有 count 位可用
+    void ensureBits(unsigned count);
+
+    // 数据末尾不足 8 字节时逐字节读取，超出部分补 0
+    uint64_t loadTail(size_t byteIndex) const;
 
 public:
     BitInputStream();
-    BitInputStream(const std::vector<uint8_t>& data);
+    // 借用 data 指向的数据，调用方需保证其在读取期间有效
+    BitInputStream(ByteSpan data);
+    BitInputStream(std::vector<uint8_t>&& data) = delete;
     ~BitInputStream();
 
     void loadFromFile(const std::string& filename);
-    void setBuffer(const std::vector<uint8_t>& data);
+    void setBuffer(ByteSpan data);
 
     bool readBit();
     std::vector<bool> readBits(size_t count);
@@ -52,15 +122,54 @@ public:
     uint8_t readByte();
     std::vector<uint8_t> readBytes(size_t count);
 
+    // 从当前位置整字读取，补充位容器使其至少有 MIN_REFILL_BITS 位；
+    // 越界检查只在这里进行，越界时抛出异常
+    inline void refill();
+    // 预读 count 位（1 <= count <= 容器可用位数）而不移动位置，超出数据末尾的部分为 0
+    inline uint32_t peek(unsigned count) const;
+    // 跳过 count 位（count <= 容器可用位数）
+    inline void consume(unsigned count);
+
     bool hasMoreBits() const;
+    // 是否读取超出了数据末尾
+    bool isOverrun() const;
     size_t getRemainingBits() const;
     size_t getCurrentPosition() const;
     size_t getSize() const;
+    const uint8_t* getData() const;
+
+    // 移动到第 position 位，之后需要重新补充位容器
+    void seek(size_t position);
 
     void reset();
     void clear();
 };
 
+// 热路径，定义在头文件中以便内联
+inline void BitInputStream::refill() {
+    size_t byteIndex = bitPosition >> 3;
+    unsigned offset = bitPosition & 7;
+    if (byteIndex + 8 <= dataSize) {
+        bitContainer = loadBigEndian64(data + byteIndex) << offset;
+    } else {
+        if (bitPosition > dataSize * 8) {
+            throw std::runtime_error("尝试读取超出缓冲区范围");
+        }
+        bitContainer = loadTail(byteIndex) << offset;
+    }
+    containerBits = 64 - offset;
+}
+
+inline uint32_t BitInputStream::peek(unsigned count) const {
+    return static_cast<uint32_t>(bitContainer >> (64 - count));
+}
+
+inline void BitInputStream::consume(unsigned count) {
+    bitContainer <<= count;
+    containerBits -= count;
+    bitPosition += count;
+}
+
 }
 
 #endif // BITSTREAM_HPP
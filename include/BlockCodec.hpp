@@ -0,0 +1,99 @@
+#ifndef BLOCKCODEC_HPP
+#define BLOCKCODEC_HPP
+
+#include "HuffmanTree.hpp"
+#include "HuffmanDecoder.hpp"
+#include "Header.hpp"
+#include "ThreadPool.hpp"
+
+namespace huffman {
+
+// 多线程编解码时每段的最小字节数
+constexpr size_t PARALLEL_CHUNK_SIZE = 256 * 1024;
+
+// 多线程解码时每段记录起始位置的符号数，真实符号边界与其中任何一个都不重合时重新解码该段
+constexpr size_t PARALLEL_SYNC_SYMBOLS = 1024;
+
+// 编码内核每次处理的字节数，按最大码长预留输出空间
+constexpr size_t ENCODE_SLICE_SIZE = 64 * 1024;
+
+// 单个数据块的编解码器
+// 持有构建编码表和解码表所需的全部状态，每个线程使用各自的实例即可并行
+class BlockCodec {
+private:
+    HuffmanTree huffmanTree;
+    HuffmanDecoder decoder;
+    bool treeWalkDecoding;  // 使用逐位遍历树的参考解码路径
+    bool useTreeWalk;       // 当前解码表是否需要遍历树
+    size_t streamCount;     // 每块的交错位流数
+
+    // 沿哈夫曼树逐位解码一个符号
+    uint8_t decodeTreeWalk(BitInputStream& bitStream) const;
+
+    // 解码一个符号
+    uint8_t decodeSymbol(BitInputStream& bitStream) const;
+
+    // 连续解码追加到 output，直到下一个符号的起始位置不小于 endBit 或共有 maxCount 个符号；
+    // 同时记录前 startCount 个符号的起始位置
+    void decodeRange(BitInputStream& bitStream, size_t endBit, size_t maxCount,
+        std::vector<uint8_t>& output, std::vector<size_t>& starts, size_t startCount) const;
+
+public:
+    BlockCodec();
+    ~BlockCodec() = default;
+
+    // 设置最大码长
+    void setMaxCodeLength(uint8_t length);
+
+    // 设置是否使用逐位遍历树解码
+    void setTreeWalkDecoding(bool enabled);
+
+    // 设置每块的交错位流数
+    void setStreamCount(size_t count);
+
+    // 统计数据频率，构建范式编码表
+    void buildEncoder(ByteSpan data);
+
+    // 分段多线程统计频率后合并，构建与 buildEncoder 相同的编码表
+    void buildEncoderParallel(ByteSpan data, ThreadPool& pool);
+
+    // 序列化码长表
+    std::vector<uint8_t> serializeTable() const;
+
+    // 按编码表压缩数据，写入位流
+    void encode(ByteSpan data, BitOutputStream& bitStream) const;
+
+    // 统计按当前编码表压缩数据所需的位数
+    uint64_t measureBits(ByteSpan data) const;
+
+    // 多线程压缩数据，从字节边界开始追加到 output，结果与 encode 逐位相同
+    void encodeParallel(ByteSpan data, std::vector<uint8_t>& output, ThreadPool& pool) const;
+
+    // 由哈夫曼树数据构建解码表：canonical 为码长表，否则为旧格式的前序遍历树
+    void buildDecoder(ByteSpan treeData, bool canonical);
+
+    // 从位流中解码 count 个字节
+    void decode(BitInputStream& bitStream, uint8_t* output, size_t count);
+
+    // 多线程推测解码单个位流中的 count 个字节
+    void decodeParallel(ByteSpan data, uint8_t* output, size_t count, ThreadPool& pool) const;
+
+    // 是否只有一个符号
+    bool isSingleSymbol() const;
+
+    // 压缩一个块，把块头、码长表和压缩数据追加到 output
+    void encodeBlock(ByteSpan block, std::vector<uint8_t>& output);
+
+    // 解码一个块，blockData 为块头之后的码长表和压缩数据
+    void decodeBlock(const BlockHeader& blockHeader, ByteSpan blockData, uint8_t* output);
+
+    // 获取最近一次构建编码表的统计信息
+    const HuffmanStats& getStats() const;
+
+    // 当前解码表是否为多符号表
+    bool isMultiSymbol() const;
+};
+
+}
+
+#endif // BLOCKCODEC_HPP
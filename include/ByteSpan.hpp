@@ -0,0 +1,47 @@
+#ifndef BYTESPAN_HPP
+#define BYTESPAN_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace huffman {
+
+// 不持有数据的只读字节视图（指针 + 长度），调用方负责保证数据的生命周期
+class ByteSpan {
+private:
+    const uint8_t* ptr;
+    size_t length;
+
+public:
+    ByteSpan() : ptr(nullptr), length(0) {}
+    ByteSpan(const uint8_t* data, size_t size) : ptr(data), length(size) {}
+    ByteSpan(const std::vector<uint8_t>& data) : ptr(data.data()), length(data.size()) {}
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    const uint8_t* begin() const { return ptr; }
+    const uint8_t* end() const { return ptr + length; }
+    uint8_t operator[](size_t index) const { return ptr[index]; }
+
+    // 截取 [offset, offset + count) 子视图
+    ByteSpan subspan(size_t offset, size_t count) const {
+        if (offset > length || count > length - offset) {
+            throw std::out_of_range("字节视图越界");
+        }
+        return ByteSpan(ptr + offset, count);
+    }
+
+    // 截取 offset 之后的全部数据
+    ByteSpan subspan(size_t offset) const {
+        return subspan(offset, length - std::min(offset, length));
+    }
+};
+
+}
+
+#endif // BYTESPAN_HPP
@@ -1,8 +1,9 @@
 #ifndef FILECOMPRESSOR_HPP
 #define FILECOMPRESSOR_HPP
 
-#include "HuffmanTree.hpp"
+#include "BlockCodec.hpp"
 #include "Header.hpp"
+#include <functional>
 
 namespace huffman {
 
@@ -10,10 +11,15 @@ namespace huffman {
     class FileCompressor {
     private:
         Header header;
-        HuffmanTree huffmanTree;
-
-        // 读取文件内容
-        static std::vector<uint8_t> readFile(const std::string &filename);
+        BlockCodec codec;
+        bool verbose = false;
+        uint16_t formatVersion = FORMAT_V2;    // 压缩时写入的格式版本
+        size_t blockSize = DEFAULT_BLOCK_SIZE; // v2 分块大小
+        size_t streamCount = 4;                // v2 每块的交错位流数
+        size_t threadCount = 1;                // v2 分块压缩/解压的线程数
+        uint8_t maxCodeLength = DEFAULT_MAX_CODE_LENGTH;
+        bool treeWalkDecoding = false;
+        bool blockIndex = false;               // v2 压缩时在结束块之后写入块索引
 
         // 写入文件
         static void writeFile(const std::string &filename, const std::vector<uint8_t> &data);
@@ -21,24 +27,105 @@ namespace huffman {
         // 设置头信息
         void setHeader(uint16_t treeSize, uint64_t originalSize, uint64_t compressedSize);
 
-        // 从压缩数据中设置头信息
-        void feadHeader(const std::vector<uint8_t> &compressedData);
+        // 单棵树 + 单个位流（v1）
+        std::vector<uint8_t> compressSingle(ByteSpan originalData);
+        std::vector<uint8_t> decompressSingle(ByteSpan compressedData);
+
+        // 分块压缩，每块独立建树（v2）
+        std::vector<uint8_t> compressBlocks(ByteSpan originalData);
+
+        // 逐块压缩的统计信息
+        struct BlockStats {
+            size_t blockCount = 0;
+            size_t maxDepth = 0;
+            uint64_t encodedBits = 0;
+            uint64_t originalSize = 0;
+            uint64_t compressedSize = 0;             // 各块压缩后的字节数之和
+            std::vector<BlockIndexEntry> index;      // 写块索引时各块的位置，块偏移相对第一块
+        };
+
+        // 逐块压缩：nextBlock 取下一块（可以读入给定的缓冲区），返回空视图表示结束；
+        // 压缩结果按块的顺序追加到 output 后调用 flush。多线程时最多 2 × 线程数个块在途
+        BlockStats encodeBlocks(const std::function<ByteSpan(std::vector<uint8_t>&)>& nextBlock,
+            std::vector<uint8_t>& output, const std::function<void()>& flush);
+
+        // 逐块解压 v2 数据：nextBlock 取下一块的块头和数据（可以读入给定的缓冲区），到结束块时返回 false；
+        // 解出的数据按块的顺序交给 sink，返回解出的字节数。多线程时最多 2 × 线程数个块在途
+        uint64_t decodeBlocks(const std::function<bool(BlockHeader&, ByteSpan&, std::vector<uint8_t>&)>& nextBlock,
+            const std::function<void(ByteSpan)>& sink);
+
+        // 结束块之后追加块索引，第一块位于文件头之后
+        static void appendBlockIndex(std::vector<uint8_t>& output, const BlockStats& stats);
+
+        // 查找文件末尾的块索引，返回索引项所在的区域并读出原始大小；没有索引时返回空视图
+        ByteSpan findBlockIndex(ByteSpan compressedData, uint64_t& originalSize) const;
+
+        // 逐块解压结束后检查原始大小，流式压缩的原始大小以各块之和为准
+        void checkOriginalSize(uint64_t outputSize);
 
     public:
         FileCompressor() = default;
         ~FileCompressor() = default;
 
         // 压缩数据
-        std::vector<uint8_t> compress(const std::vector<uint8_t> &originalData);
+        std::vector<uint8_t> compress(ByteSpan originalData);
 
         // 解压数据
-        std::vector<uint8_t> decompress(const std::vector<uint8_t> &compressedData);
+        std::vector<uint8_t> decompress(ByteSpan compressedData);
 
         // 从文件压缩数据
         void compressToFile(const std::vector<uint8_t> &originalData, const std::string &output);
 
-        // 从文件解压数据
-        void decompressFromFile(const std::string &input, std::vector<uint8_t> &data);
+        // 流式压缩：从 inputFd 逐块读取，压缩后逐块写入 outputFd，内存占用与输入大小无关。
+        // 写入 v2 格式并带 FLAG_STREAM 标志，内容为单个字节流
+        void compressStream(int inputFd, int outputFd);
+
+        // 流式解压：从 inputFd 读取文件头后逐块解压，按顺序把每块的数据交给 sink。
+        // v2 格式的内存占用与块大小相关，与文件大小无关；v1 格式只有一个位流，整体解压后一次交出
+        void decompressStream(int inputFd, const std::function<void(ByteSpan)>& sink);
+
+        // 同上，压缩数据已在内存中（如映射的文件），各块直接引用输入解码，不复制
+        void decompressStream(ByteSpan compressedData, const std::function<void(ByteSpan)>& sink);
+
+        // 解压原始数据中 [offset, offset + length) 的部分，超出末尾的部分截去。
+        // 带块索引时二分查找起始块，否则扫描块头跳过之前的块，只解码覆盖该范围的块；v1 格式整体解压后截取
+        std::vector<uint8_t> decompressRange(ByteSpan compressedData, uint64_t offset, uint64_t length);
+
+        // 从压缩数据中设置头信息
+        void readHeader(ByteSpan compressedData);
+
+        // 最近一次压缩或解压的文件头，流式解压时在第一次调用 sink 之前即已读入
+        const Header& getHeader() const;
+
+        // 从文件描述符读满 size 字节，返回实际读到的字节数（不足时到达末尾）
+        static size_t readFull(int fd, uint8_t* data, size_t size);
+
+        // 向文件描述符写入全部数据
+        static void writeFull(int fd, const uint8_t* data, size_t size);
+
+        // 设置是否输出详细信息
+        void setVerbose(bool verbose);
+
+        // 设置最大码长
+        void setMaxCodeLength(uint8_t length);
+
+        // 设置 v2 分块大小
+        void setBlockSize(size_t size);
+
+        // 设置分块处理的线程数，0 表示使用全部硬件线程
+        void setThreadCount(size_t count);
+
+        // 设置 v2 每块的交错位流数
+        void setStreamCount(size_t count);
+
+        // 设置压缩时写入的格式版本
+        void setFormatVersion(uint16_t version);
+
+        // 设置 v2 压缩时是否写入块索引
+        void setBlockIndex(bool enabled);
+
+        // 设置是否使用逐位遍历树解码（参考实现，用于校验和性能对比）
+        void setTreeWalkDecoding(bool enabled);
 
         // 清空状态
         void clear();
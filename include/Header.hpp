@@ -2,17 +2,63 @@
 #define HEADER_HPP
 
 #include <cstdint>
+#include <cstddef>
 
 constexpr uint32_t MAGIC_NUMBER = 0x48554646; // "HUFF"
+constexpr uint32_t INDEX_MAGIC = 0x48494458;  // "HIDX"
 
-// 压缩文件格式：
+// 标志位
+constexpr uint16_t FLAG_CANONICAL = 0x0001; // 哈夫曼树数据为范式编码的码长表
+// 流式压缩（仅 v2）：内容为单个字节流而非打包的目录项，
+// 写入时大小未知，文件头中的原始大小和压缩大小为 0，以结束块为准
+constexpr uint16_t FLAG_STREAM = 0x0002;
+// 结束块之后带块索引（仅 v2），可以按原始偏移直接定位块
+constexpr uint16_t FLAG_INDEX = 0x0004;
+
+// 标志位高 4 位为格式版本，0 视为 v1
+constexpr uint16_t FORMAT_VERSION_MASK = 0xF000;
+constexpr uint16_t FORMAT_VERSION_SHIFT = 12;
+constexpr uint16_t FORMAT_V1 = 1; // 单棵树 + 单个位流
+constexpr uint16_t FORMAT_V2 = 2; // 分块，每块独立编码
+
+// 标志位 8~11 位为 v2 每块交错位流数的 log2，0 表示单个位流
+constexpr uint16_t STREAM_LAYOUT_MASK = 0x0F00;
+constexpr uint16_t STREAM_LAYOUT_SHIFT = 8;
+constexpr size_t MAX_STREAM_COUNT = 4;
+
+// v2 分块大小
+constexpr size_t MIN_BLOCK_SIZE = 64 * 1024;
+constexpr size_t MAX_BLOCK_SIZE = 8 * 1024 * 1024;
+constexpr size_t DEFAULT_BLOCK_SIZE = 1024 * 1024;
+// 块头中码长表与块压缩数据的大小之和的上限：压缩后不比原数据小的块直接存储，这里留出余量
+constexpr size_t MAX_BLOCK_DATA_SIZE = 2 * MAX_BLOCK_SIZE;
+
+// 块标志位
+constexpr uint16_t BLOCK_FLAG_RAW = 0x0001; // 块数据未压缩，直接存储
+
+// 压缩文件格式（v1）：
 // [4字节：Magic Number]
 // [2字节：标志位]
 // [2字节: 哈夫曼树大小]
 // [8字节: 原始文件大小]
 // [8字节: 压缩文件大小]
-// [N字节: 哈夫曼树数据]
+// [N字节: 哈夫曼树数据]（FLAG_CANONICAL 时为码长表）
 // [M字节: 压缩后的文件内容]
+//
+// 压缩文件格式（v2）：
+// [文件头]（哈夫曼树大小为 0，压缩文件大小为文件头之后的全部字节数，FLAG_STREAM 时均为 0）
+// 若干个块，每块：
+//   [12字节: 块头]
+//   [N字节: 码长表]
+//     按大小区分格式：奇数字节为（符号, 码长）对的列表，128 字节为每符号 4 位的码长（最大码长不超过 15），
+//     256 字节为每符号 1 字节的码长；写入时取最小的一种，v1 的码长表相同
+//   [M字节: 块压缩数据]
+//     交错位流数 S 大于 1 时为 [(S-1)×4字节: 前 S-1 个位流的大小][S 个位流]，
+//     块内符号均分为 S 段，每段 (原始大小+S-1)/S 个符号（最后一段可能更短），依次编码到各位流
+// [12字节: 原始大小为 0 的块头，表示结束]
+// FLAG_INDEX 时其后为块索引（不计入压缩文件大小）：
+//   [块数 × 16字节: 块的原始偏移（8字节）, 块头在文件中的偏移（8字节）]，按原始偏移递增
+//   [8字节: 原始大小][8字节: 块数][4字节: 索引标识 "HIDX"]，位于文件末尾
 
 #pragma pack(push, 1)
 
@@ -30,10 +76,66 @@ struct Header {
         , originalSize(0)
         , compressedSize(0) 
     {}
+
+    uint16_t getFormatVersion() const {
+        uint16_t version = (flags & FORMAT_VERSION_MASK) >> FORMAT_VERSION_SHIFT;
+        return version == 0 ? FORMAT_V1 : version;
+    }
+
+    void setFormatVersion(uint16_t version) {
+        flags = (flags & ~FORMAT_VERSION_MASK) | (version << FORMAT_VERSION_SHIFT);
+    }
+
+    size_t getStreamCount() const {
+        return size_t(1) << ((flags & STREAM_LAYOUT_MASK) >> STREAM_LAYOUT_SHIFT);
+    }
+
+    // count 须为 2 的幂
+    void setStreamCount(size_t count) {
+        uint16_t layout = 0;
+        while ((size_t(1) << layout) < count) {
+            layout++;
+        }
+        flags = (flags & ~STREAM_LAYOUT_MASK) | (layout << STREAM_LAYOUT_SHIFT);
+    }
+};
+
+struct BlockHeader {
+    uint32_t originalSize;   // 块原始大小，0 表示结束
+    uint32_t compressedSize; // 块压缩数据大小（不含块头和码长表）
+    uint16_t tableSize;      // 码长表大小
+    uint16_t flags;          // 块标志位
+
+    BlockHeader()
+        : originalSize(0)
+        , compressedSize(0)
+        , tableSize(0)
+        , flags(0)
+    {}
+};
+
+struct BlockIndexEntry {
+    uint64_t originalOffset; // 块的第一个字节在原始数据中的偏移
+    uint64_t blockOffset;    // 块头在压缩文件中的偏移
+};
+
+struct IndexTrailer {
+    uint64_t originalSize; // 原始大小（流式压缩时文件头中没有）
+    uint64_t blockCount;   // 索引项数
+    uint32_t magicNumber;
+
+    IndexTrailer()
+        : originalSize(0)
+        , blockCount(0)
+        , magicNumber(INDEX_MAGIC)
+    {}
 };
 
 constexpr uint8_t HEADER_SIZE = sizeof(Header);
+constexpr uint8_t BLOCK_HEADER_SIZE = sizeof(BlockHeader);
+constexpr uint8_t INDEX_ENTRY_SIZE = sizeof(BlockIndexEntry);
+constexpr uint8_t INDEX_TRAILER_SIZE = sizeof(IndexTrailer);
 
 #pragma pack(pop)
 
-#endif // HEADER_HPP
\ No newline at end of file
+#endif // HEADER_HPP
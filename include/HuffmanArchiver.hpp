@@ -4,6 +4,7 @@
 #include "FileCompressor.hpp"
 #include "Packer.hpp"
 #include <functional>
+#include <memory>
 #include <string>
 
 namespace huffman {
@@ -13,8 +14,6 @@ class HuffmanArchiver {
 private:
     std::unique_ptr<Packer> packer;
     std::unique_ptr<FileCompressor> fileCompressor;
-
-    void setVerbose(bool verbose);
     
     // 获取文件扩展名
     static std::string getExtension(const std::string& path);
@@ -26,18 +25,55 @@ public:
     HuffmanArchiver();
     ~HuffmanArchiver() = default;
 
+    // 设置是否输出详细信息
+    void setVerbose(bool verbose);
+
+    // 设置压缩时的最大码长
+    void setMaxCodeLength(uint8_t length);
+
+    // 设置压缩时的分块大小
+    void setBlockSize(size_t size);
+
+    // 设置压缩时每块的交错位流数
+    void setStreamCount(size_t count);
+
+    // 设置线程数，0 表示使用全部硬件线程
+    void setThreadCount(size_t count);
+
+    // 设置压缩时写入旧的单流格式（v1）
+    void setLegacyFormat(bool enabled);
+
+    // 设置压缩时是否写入块索引，以便按范围解压
+    void setBlockIndex(bool enabled);
+
+    // 设置解压时是否使用逐位遍历树的参考解码路径
+    void setTreeWalkDecoding(bool enabled);
+
     // 压缩文件或目录
     // sources: 源文件或目录路径列表
     // output: 输出文件路径（如果为空，自动生成）
     // 返回值: 是否成功
     bool compress(const std::vector<std::string>& sources, const std::string& output = "");
 
-    // 解压文件或目录
-    // source: 压缩文件路径
-    // output: 输出路径（如果为空，自动生成）
+    // 流式压缩标准输入
+    // output: 输出文件路径（为空或 "-" 时写到标准输出）
+    // 返回值: 是否成功
+    bool compressStream(const std::string& output = "");
+
+    // 解压文件或目录，逐块解压并立即写出
+    // source: 压缩文件路径（"-" 表示标准输入）
+    // output: 输出路径（如果为空，自动生成；"-" 表示标准输出，仅限流式压缩的文件）
     // 返回值: 是否成功
     bool decompress(const std::string& source, const std::string& output = "");
 
+    // 解压原始数据中 [offset, offset + length) 的部分，只解码覆盖该范围的块
+    // 只含单个文件的压缩文件以该文件的内容为准；打包的目录或多个文件不支持
+    // source: 压缩文件路径，必须是普通文件
+    // output: 输出文件路径（为空或 "-" 时写到标准输出）
+    // 返回值: 是否成功
+    bool decompressRange(const std::string& source, uint64_t offset, uint64_t length,
+                         const std::string& output = "");
+
     // 获取版本信息
     static std::string getVersion();
 
@@ -0,0 +1,97 @@
+#ifndef HUFFMANDECODER_HPP
+#define HUFFMANDECODER_HPP
+
+#include "HuffmanTree.hpp"
+#include "BitStream.hpp"
+
+namespace huffman {
+
+struct DecodeTables;
+
+constexpr uint8_t DECODE_TABLE_BITS = 11; // 一级查找表索引位数
+
+// 查找表项
+struct DecodeEntry {
+    uint16_t value;  // 符号，或二级表起始位置
+    uint8_t length;  // 码长，0 表示需要查二级表
+    uint8_t subBits; // 二级表索引位数
+};
+
+constexpr uint8_t MULTI_SYMBOL_COUNT = 4; // 多符号表项最多包含的符号数
+
+// 多符号查找表项：一次查表连续解出多个符号
+struct MultiDecodeEntry {
+    uint8_t symbols[MULTI_SYMBOL_COUNT]; // 依次解出的符号
+    uint8_t count;                       // 符号数，0 表示需回退到单符号解码
+    uint8_t bits;                        // 消耗的总位数
+};
+
+// 范式哈夫曼解码器
+// 直接由码长表构建解码表，不需要重建树节点
+// 一次预读 tableBits 位，在一级表中同时得到符号和码长；
+// 码长超过 tableBits 的码字再查对应前缀的二级表
+class HuffmanDecoder {
+private:
+    std::array<uint16_t, MAX_CODE_LENGTH + 1> lengthCount; // 每种码长的符号数
+    std::array<uint8_t, SYMBOL_COUNT> sortedSymbols;       // 按（码长, 符号）排序的符号
+    uint16_t symbolCount;                                  // 符号总数
+    uint8_t maxLength;                                     // 最大码长
+
+    std::vector<DecodeEntry> primaryTable;   // 一级查找表
+    std::vector<DecodeEntry> secondaryTable; // 二级查找表
+    std::vector<MultiDecodeEntry> multiTable; // 多符号查找表
+    uint8_t tableBits;                       // 一级表索引位数
+    bool tableReady;                         // 查找表是否可用
+
+    // 构建查找表，二级表过大时保留逐位解码
+    void buildTables(const CodeLengths& lengths);
+
+    // 根据码长分布判断是否值得使用多符号表，若是则构建
+    void buildMultiTable(const CodeLengths& lengths);
+
+    // 查表解码一个符号，要求位容器中至少有 maxLength 位
+    inline uint8_t decodeOne(BitInputStream& bitStream) const;
+
+    // 逐位解码一个符号
+    uint8_t decodeSerial(BitInputStream& bitStream) const;
+
+    // 供解码内核使用的查找表
+    DecodeTables kernelTables() const;
+
+public:
+    HuffmanDecoder();
+    ~HuffmanDecoder() = default;
+
+    // 由码长表构建解码表
+    void build(const CodeLengths& lengths);
+
+    // 从位流中解码一个符号
+    uint8_t decodeSymbol(BitInputStream& bitStream) const;
+
+    // 从位流中连续解码 count 个符号
+    void decode(BitInputStream& bitStream, uint8_t* output, size_t count) const;
+
+    // 从 streamCount 个交错位流中解码 count 个符号，第 i 个位流对应输出中第 i 段；
+    // 每 4 个位流一组，在同一个循环中推进 4 条互不依赖的解码链
+    void decodeInterleaved(BitInputStream* streams, size_t streamCount, uint8_t* output, size_t count) const;
+
+    // 从位流中连续解码，直到下一个符号的起始位置不小于 endBit 或已解出 maxCount 个符号；
+    // 返回解出的符号数
+    size_t decodeUntil(BitInputStream& bitStream, size_t endBit, uint8_t* output, size_t maxCount) const;
+
+    // 是否使用多符号查找表
+    bool isMultiSymbol() const;
+
+    // 是否只有一个符号
+    bool isSingleSymbol() const;
+
+    // 获取第一个符号（只有一个符号时即为该符号）
+    uint8_t getFirstSymbol() const;
+
+    // 清空解码表
+    void clear();
+};
+
+}
+
+#endif // HUFFMANDECODER_HPP
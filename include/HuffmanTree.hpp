@@ -2,86 +2,130 @@
 #define HUFFMANTREE_HPP
 
 #include <vector>
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <memory>
-#include <unordered_map>
+#include "ByteSpan.hpp"
 
 namespace huffman {
 
+constexpr size_t SYMBOL_COUNT = 256;     // 符号（字节）种类数
+constexpr uint8_t MAX_CODE_LENGTH = 32;  // 码长上限（码字保存在 uint32_t 中）
+
+// 码长表按大小区分格式：（符号, 码长）对的列表总为奇数字节，稠密格式为以下两种偶数大小
+constexpr size_t NIBBLE_TABLE_SIZE = SYMBOL_COUNT / 2; // 每个符号 4 位码长，最大码长不超过 15
+constexpr size_t BYTE_TABLE_SIZE = SYMBOL_COUNT;       // 每个符号 1 字节码长
+constexpr uint8_t MAX_NIBBLE_CODE_LENGTH = 15;
+
+constexpr uint8_t DEFAULT_MAX_CODE_LENGTH = 11; // 默认限制的最大码长
+constexpr uint8_t MIN_CODE_LENGTH_LIMIT = 8;    // 可设置的码长限制下限（256 个符号）
+constexpr uint8_t MAX_CODE_LENGTH_LIMIT = 32;   // 可设置的码长限制上限
+
+// 每个符号的码长，0 表示该符号未出现
+using CodeLengths = std::array<uint8_t, SYMBOL_COUNT>;
+
+// 每个符号的出现次数，0 表示该符号未出现
+using Frequencies = std::array<uint64_t, SYMBOL_COUNT>;
+
+constexpr uint16_t MAX_NODE_COUNT = 2 * SYMBOL_COUNT - 1; // 节点数上限
+constexpr uint16_t NULL_NODE = 0xFFFF;                    // 空节点索引
+
+// 树节点保存在 HuffmanTree 的连续数组中，子节点用数组下标表示
 struct HuffmanNode {
-    uint8_t data;                       // 字符数据
-    uint32_t frequency;                 // 出现频率
-    bool isLeaf;                        // 是否为叶节点
-    std::shared_ptr<HuffmanNode> left;  // 左子树
-    std::shared_ptr<HuffmanNode> right; // 右子树
-
-    HuffmanNode(uint8_t d, uint32_t freq, bool leaf = true)
-        : data(d), frequency(freq), isLeaf(leaf), left(nullptr), right(nullptr) {}
-
-    HuffmanNode(std::shared_ptr<HuffmanNode> l, std::shared_ptr<HuffmanNode> r)
-        : data(0), frequency(l->frequency + r->frequency), 
-          isLeaf(false), left(l), right(r) {}
+    uint64_t frequency; // 出现频率
+    uint16_t left;      // 左子树下标
+    uint16_t right;     // 右子树下标
+    uint8_t data;       // 字符数据
+    bool isLeaf;        // 是否为叶节点
 };
 
-struct NodeComparator {
-    bool operator()(const std::shared_ptr<HuffmanNode>& a,
-        const std::shared_ptr<HuffmanNode>& b) {
-        return a->frequency > b->frequency;
-    }
+// 编码表项，码字右对齐保存，高位先输出
+struct CodeEntry {
+    uint32_t code; // 码字
+    uint8_t len;   // 码长，0 表示符号未出现
 };
 
-struct VectorBoolHash {
-    uint32_t operator()(const std::vector<bool>& bits) const {
-        uint32_t result = 0;
-        for (auto bit : bits) {
-            result = (result << 1) | (bit ? 1 : 0);
-        }
-        return result;
-    }
+// 按符号下标直接索引的编码表
+using EncodeTable = std::array<CodeEntry, SYMBOL_COUNT>;
+
+// 编码统计信息
+struct HuffmanStats {
+    size_t unlimitedDepth;  // 不限码长时的最大码长
+    size_t depth;           // 实际最大码长
+    uint64_t unlimitedBits; // 不限码长时的编码总位数
+    uint64_t encodedBits;   // 实际编码总位数
 };
 
 class HuffmanTree {
 private:
-    std::shared_ptr<HuffmanNode> root;
-    std::unordered_map<uint8_t, std::vector<bool>> codeTable;
-    std::unordered_map<std::vector<bool>, uint8_t, VectorBoolHash> reverseCodeTable;
+    std::array<HuffmanNode, MAX_NODE_COUNT> nodes; // 节点数组
+    uint16_t nodeCount;                            // 已使用的节点数
+    uint16_t root;                                 // 根节点下标
+    EncodeTable encodeTable;
+    CodeLengths codeLengths;
+    uint16_t symbolCount;
+    uint8_t maxCodeLength;
+    HuffmanStats stats;
 
-    // 递归生成编码表
-    void generateCodes(const std::shared_ptr<HuffmanNode>& node,
-                       std::vector<bool>& currentCode);
+    // 用 package-merge 算法求码长不超过 maxCodeLength 的最优码长
+    CodeLengths limitCodeLengths(const Frequencies& frequencies) const;
+
+    // 分配叶子节点
+    uint16_t newLeaf(uint8_t data, uint64_t frequency);
+
+    // 分配内部节点
+    uint16_t newInternal(uint16_t left, uint16_t right);
 
-    // 序列化树到字节数组
-    void serializeTree(const std::shared_ptr<HuffmanNode>& node,
-        std::vector<uint8_t>& output) const;
+    // 递归统计各叶子的码长
+    void collectLengths(uint16_t node, uint8_t depth, CodeLengths& lengths) const;
+
+    // 递归生成编码表
+    void generateCodes(uint16_t node, uint64_t code, uint8_t depth);
 
     // 反序列化树
-    std::shared_ptr<HuffmanNode> deserializeTree(const std::vector<uint8_t>& data,
-        size_t& index);
+    uint16_t deserializeTree(ByteSpan data, size_t& index);
 
 public:
     HuffmanTree();
     ~HuffmanTree();
 
+    // 设置最大码长
+    void setMaxCodeLength(uint8_t length);
+
     // 从频率表构建哈夫曼树
-    void buildFromFrequencies(const std::unordered_map<uint8_t, uint32_t>& frequencies);
+    void buildFromFrequencies(const Frequencies& frequencies);
 
     // 从原始数据构建哈夫曼树
-    void buildFromData(const std::vector<uint8_t>& data);
+    void buildFromData(ByteSpan data);
+
+    // 从码长表构建范式哈夫曼编码，只生成编码表，不建树
+    void buildFromLengths(const CodeLengths& lengths);
+
+    // 按编码表重建树结构，只有逐位遍历树解码需要
+    void rebuildTreeFromCodes();
 
     // 获取字符的编码
-    std::vector<bool> getCode(uint8_t byte) const;
+    const CodeEntry& getCode(uint8_t byte) const;
 
     // 获取编码表
-    const std::unordered_map<uint8_t, std::vector<bool>>& getCodeTable() const;
+    const EncodeTable& getEncodeTable() const;
 
-    // 获取根节点
-    std::shared_ptr<HuffmanNode> getRoot() const;
+    // 获取根节点下标、按下标获取节点，供逐位遍历树解码使用；
+    // 只在 deserialize 或 rebuildTreeFromCodes 之后有效，其他构建方式不保留树结构，根节点为 NULL_NODE
+    uint16_t getRoot() const;
+    const HuffmanNode& getNode(uint16_t index) const;
 
-    // 序列化哈夫曼树
-    std::vector<uint8_t> serialize() const;
+    // 反序列化旧格式的前序遍历树（只用于解压旧文件）
+    void deserialize(ByteSpan data);
 
-    // 反序列化哈夫曼树
-    void deserialize(const std::vector<uint8_t>& data);
+    // 获取码长表
+    const CodeLengths& getCodeLengths() const;
+
+    // 序列化码长表（范式编码），取（符号, 码长）对列表和稠密格式中较小的一种
+    std::vector<uint8_t> serializeLengths() const;
+
+    // 反序列化码长表，并校验其能构成合法的前缀码
+    static CodeLengths deserializeLengths(ByteSpan data);
 
     // 清空树
     void clear();
@@ -89,9 +133,15 @@ public:
     // 检查树是否为空
     bool isEmpty() const;
 
-    // 获取树的深度
+    // 获取有编码的符号数
+    size_t getSymbolCount() const;
+
+    // 获取最大码长，即树的深度；编码端构建时与统计信息中的 depth 相同
     size_t getDepth() const;
 
+    // 获取最近一次构建的编码统计信息
+    const HuffmanStats& getStats() const;
+
     // 打印编码表
     void printCodeTable() const;
 };
@@ -0,0 +1,75 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include "HuffmanTree.hpp"
+#include "HuffmanDecoder.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace huffman {
+
+// 内核指令集，按能力从低到高排列
+enum class Isa {
+    Scalar,
+    Bmi2,
+    Avx2,
+    Avx512
+};
+
+// 解码内核使用的查找表，由 HuffmanDecoder 提供
+struct DecodeTables {
+    const DecodeEntry* primary;
+    const DecodeEntry* secondary;
+    const MultiDecodeEntry* multi; // 不使用多符号表时为空
+    unsigned tableBits;
+    unsigned maxLength;
+};
+
+// 解码内核遇到无效编码时的返回值
+constexpr size_t DECODE_INVALID = SIZE_MAX;
+
+// 同一指令集编译的一组热路径内核
+struct KernelTable {
+    Isa isa;
+
+    // 把 data 中每个字节的出现次数累加到 counts[256]
+    void (*histogram)(const uint8_t* data, size_t size, uint64_t* counts);
+
+    // 按编码表把 data 编码为大端 64 位整字写入 out，返回写入的字节数；
+    // maxLength 为编码表中的最大码长，bitBuffer 的低 bitCount 位为尚未写出的位，进入和返回时都如此
+    size_t (*encode)(const CodeEntry* table, unsigned maxLength, const uint8_t* data, size_t size,
+        uint8_t* out, uint64_t& bitBuffer, unsigned& bitCount);
+
+    // 从 data 的第 position 位开始解码 count 个符号，返回结束位置，遇到无效编码时返回 DECODE_INVALID；
+    // 超出数据末尾的位按 0 读取，由调用方检查是否越界
+    size_t (*decode)(const DecodeTables& tables, const uint8_t* data, size_t size, size_t position,
+        uint8_t* output, size_t count);
+
+    // 4 个位流交替推进，直到 indices 中任一位流距 count 不足一批；
+    // positions 与 indices 记录各位流的位置和已解出的符号数，遇到无效编码时返回 false
+    bool (*decode4)(const DecodeTables& tables, const uint8_t* const* data, const size_t* sizes,
+        size_t* positions, uint8_t* const* outputs, size_t* indices, size_t count);
+};
+
+// CPU 支持的最高指令集
+Isa detectIsa();
+
+// 当前使用的内核。首次调用时选择：环境变量 HUFFMAN_ISA 指定的指令集，否则为 CPU 支持的最高指令集
+const KernelTable& getKernels();
+
+// 当前内核的指令集
+Isa getIsa();
+
+// 强制使用指定指令集的内核，需在启动工作线程之前调用；CPU 不支持或未编译该版本时抛出异常
+void setIsa(Isa isa);
+
+// 指令集名称：scalar、bmi2、avx2、avx512
+const char* isaName(Isa isa);
+
+// 由名称解析指令集，无法识别时抛出异常
+Isa parseIsa(const std::string& name);
+
+}
+
+#endif // KERNELS_HPP
@@ -0,0 +1,36 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include "ByteSpan.hpp"
+#include <string>
+
+namespace huffman {
+
+// 只读映射整个文件，析构时解除映射
+// 解码直接读取映射的页面，不经过用户态缓冲区复制；重复解压时由页缓存直接提供数据
+class MappedFile {
+private:
+    const uint8_t* address; // 映射起始地址，空文件为 nullptr
+    size_t length;          // 文件大小
+
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 映射的全部数据
+    ByteSpan data() const;
+    size_t size() const;
+
+    // 提示内核将按顺序读取整个文件：加大预读，并立即开始读入
+    void adviseSequential() const;
+
+    // 提示内核将随机读取少量页面：关闭预读，只读入实际访问的页面
+    void adviseRandom() const;
+};
+
+}
+
+#endif // MAPPEDFILE_HPP
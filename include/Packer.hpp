@@ -44,13 +44,11 @@ typedef std::function<void(const std::string& currentFile,
 class Packer {
 private:
     ProgressCallback progressCallback;
+    bool verbose = false;
 
     // 读取文件内容
     std::vector<uint8_t> readFile(const std::string& filename);
 
-    // 写入文件
-    void writeFile(const std::string& filename, const std::vector<uint8_t>& data);
-
     // 组合路径
     std::string combinePath(const std::string& dir, const std::string& file);
 
@@ -61,18 +59,22 @@ private:
     // 序列化目录项
     void serializeEntry(const DirectoryEntry& entry, BitOutputStream& bitStream);
 
-    // 反序列化目录项
-    DirectoryEntry deserializeEntry(BitInputStream& bitStream);
-
 public:
     Packer() = default;
     ~Packer() = default;
 
+    // 设置是否输出详细信息
+    void setVerbose(bool verbose);
+
     // 打包文件或目录
     std::vector<uint8_t> pack(const std::vector<std::string>& sources);
 
-    // 解包文件或目录
-    void unpack(const std::vector<uint8_t>& packedData, const std::string& outputDir);
+    // 文件目录项头部的最大长度：类型、路径长度、路径和文件大小
+    static constexpr size_t MAX_FILE_HEADER_SIZE = 1 + 2 + 0xFFFF + 8;
+
+    // 解析打包数据开头的文件目录项头部，得到文件内容在打包数据中的偏移和文件大小；
+    // 第一项不是文件或数据不完整时返回 false
+    static bool parseFileHeader(ByteSpan data, uint64_t& contentOffset, uint64_t& fileSize);
 };
 
 }
@@ -0,0 +1,42 @@
+#ifndef STREAMUNPACKER_HPP
+#define STREAMUNPACKER_HPP
+
+#include "ByteSpan.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace huffman {
+
+// 增量解包 Packer 打包的目录项
+// 打包数据可以按任意大小分段送入，文件内容到达后直接写入磁盘，不在内存中保留整个文件
+class StreamUnpacker {
+private:
+    std::string outputDir;
+    std::vector<uint8_t> pending; // 尚未解析完整的目录项头部
+    std::ofstream file;           // 正在写入的文件
+    std::string filePath;         // 正在写入的文件路径
+    uint64_t remaining;           // 当前文件还需写入的字节数
+    bool finished;                // 已读到结束标记
+
+    // 尝试从 pending 解析一个完整的目录项头部，成功时创建目录或打开文件
+    void parseEntry();
+
+    // 当前文件写入完成
+    void closeFile();
+
+public:
+    explicit StreamUnpacker(const std::string& outputDir);
+    ~StreamUnpacker() = default;
+
+    // 送入下一段打包数据
+    void write(ByteSpan data);
+
+    // 数据全部送入后调用，检查是否读到结束标记
+    void finish();
+};
+
+}
+
+#endif // STREAMUNPACKER_HPP
@@ -1,4 +1,6 @@
 #include "BitStream.hpp"
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <fstream>
 
@@ -6,64 +8,127 @@ namespace huffman {
 
 /*==================== BitOutputStream ======================*/
 
-BitOutputStream::BitOutputStream() : currentByte(0), bitCount(0) {}
+BitOutputStream::BitOutputStream() : byteCount(0), bitBuffer(0), bitCount(0) {}
+
+BitOutputStream::BitOutputStream(std::vector<uint8_t>&& prefix)
+    : buffer(std::move(prefix)), byteCount(buffer.size()), bitBuffer(0), bitCount(0) {}
 
 BitOutputStream::~BitOutputStream() = default;
 
-void BitOutputStream::writeBit(bool bit) {
-    currentByte = (currentByte << 1) | (bit ? 1 : 0);
-    bitCount++;
+void BitOutputStream::storeWord(uint64_t word) {
+    if (byteCount + 8 > buffer.size()) {
+        buffer.resize(std::max<size_t>(buffer.size() * 2, byteCount + 64));
+    }
+    storeBigEndian64(buffer.data() + byteCount, word);
+    byteCount += 8;
+}
 
-    if (bitCount == 8) {
-        buffer.push_back(currentByte);
-        currentByte = 0;
-        bitCount = 0;
+void BitOutputStream::drainBytes() {
+    if (bitCount < 8) {
+        return;
     }
+
+    // 左对齐后整字写入，只推进完整字节数
+    unsigned bytes = bitCount / 8;
+    if (byteCount + 8 > buffer.size()) {
+        buffer.resize(std::max<size_t>(buffer.size() * 2, byteCount + 64));
+    }
+    storeBigEndian64(buffer.data() + byteCount, bitBuffer << (64 - bitCount));
+    byteCount += bytes;
+    bitCount -= bytes * 8;
 }
 
-void BitOutputStream::writeBits(std::vector<bool> bits) {
+void BitOutputStream::writeBit(bool bit) {
+    writeBits(bit ? 1 : 0, 1);
+}
+
+void BitOutputStream::writeBits(const std::vector<bool>& bits) {
     for (auto bit : bits) {
         writeBit(bit);
     }
 }
 
 void BitOutputStream::writeByte(uint8_t byte) {
-    if (bitCount > 0) {
-        currentByte = (currentByte << (8 - bitCount)) | (byte >> bitCount);
-        buffer.push_back(currentByte);
-        currentByte = byte & ((1 << bitCount) - 1);
-    } else {
-        buffer.push_back(byte);
-    }
+    writeBits(byte, 8);
+}
+
+void BitOutputStream::writeBytes(const std::vector<uint8_t>& bytes) {
+    writeBytes(bytes.data(), bytes.size());
 }
 
-void BitOutputStream::writeBytes(std::vector<uint8_t> bytes) {
-    for (auto byte : bytes) {
-        writeByte(byte);
+void BitOutputStream::writeBytes(const uint8_t* data, size_t size) {
+    if (bitCount % 8 != 0) {
+        for (size_t i = 0; i < size; i++) {
+            writeBits(data[i], 8);
+        }
+        return;
     }
+
+    // 字节对齐时直接复制
+    drainBytes();
+    reserve(byteCount + size);
+    std::memcpy(buffer.data() + byteCount, data, size);
+    byteCount += size;
 }
 
 void BitOutputStream::flush() {
-    if (bitCount > 0) {
-        currentByte = currentByte << (8 - bitCount);
-        buffer.push_back(currentByte);
-        currentByte = 0;
-        bitCount = 0;
+    if (bitCount % 8 != 0) {
+        writeBits(0, 8 - bitCount % 8);
     }
+    drainBytes();
 }
 
 void BitOutputStream::clear() {
     buffer.clear();
-    currentByte = 0;
+    byteCount = 0;
+    bitBuffer = 0;
     bitCount = 0;
 }
 
+void BitOutputStream::reserve(size_t bytes) {
+    if (buffer.size() < bytes + 8) {
+        buffer.resize(bytes + 8);
+    }
+}
+
+uint8_t* BitOutputStream::beginDirect(size_t maxBytes, uint64_t& bits, unsigned& count) {
+    // 容量按倍数增长；只把需要的部分加入缓冲区，已写入的数据不会被重新清零
+    size_t required = byteCount + maxBytes + 8;
+    if (required > buffer.size()) {
+        if (required > buffer.capacity()) {
+            buffer.reserve(std::max(buffer.capacity() * 2, required));
+        }
+        buffer.resize(required);
+    }
+    bits = bitBuffer;
+    count = bitCount;
+    return buffer.data() + byteCount;
+}
+
+void BitOutputStream::endDirect(size_t bytes, uint64_t bits, unsigned count) {
+    byteCount += bytes;
+    bitBuffer = bits;
+    bitCount = count;
+}
+
 auto BitOutputStream::getBuffer() const -> std::vector<uint8_t> {
-    return buffer;
+    std::vector<uint8_t> result(buffer.begin(), buffer.begin() + byteCount);
+    for (unsigned i = 8; i <= bitCount; i += 8) {
+        result.push_back(static_cast<uint8_t>(bitBuffer >> (bitCount - i)));
+    }
+    return result;
 }
 
-auto BitOutputStream::getBitCount() const -> int {
-    return buffer.size() * 8 + bitCount;
+auto BitOutputStream::takeBuffer() -> std::vector<uint8_t> {
+    flush();
+    buffer.resize(byteCount);
+    std::vector<uint8_t> result = std::move(buffer);
+    clear();
+    return result;
+}
+
+auto BitOutputStream::getBitCount() const -> size_t {
+    return byteCount * 8 + bitCount;
 }
 
 void BitOutputStream::writeToFile(const std::string& filename) {
@@ -71,16 +136,19 @@ void BitOutputStream::writeToFile(const std::string& filename) {
     if (!file) {
         throw std::runtime_error("无法打开文件：" + filename);
     }
-    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    std::vector<uint8_t> data = getBuffer();
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
     file.close();
 }
 
 /*==================== BitInputStream ======================*/
 
-BitInputStream::BitInputStream() : byteIndex(0), bitIndex(0) {}
+BitInputStream::BitInputStream()
+    : data(nullptr), dataSize(0), bitPosition(0), bitContainer(0), containerBits(0) {}
 
-BitInputStream::BitInputStream(const std::vector<uint8_t>& data)
-    : buffer(data), byteIndex(0), bitIndex(0) {}
+BitInputStream::BitInputStream(ByteSpan data) : BitInputStream() {
+    setBuffer(data);
+}
 
 BitInputStream::~BitInputStream() = default;
 
@@ -93,34 +161,45 @@ void BitInputStream::loadFromFile(const std::string& filename) {
     std::streamsize size = file.tellg();
     file.seekg(0, std::ios::beg);
     
-    buffer.resize(size);
-    if (!file.read(reinterpret_cast<char*>(buffer.data()), size)) {
+    ownedBuffer.resize(size);
+    if (!file.read(reinterpret_cast<char*>(ownedBuffer.data()), size)) {
         throw std::runtime_error("读取文件失败：" + filename);
     }
     
-    byteIndex = 0;
-    bitIndex = 0;
+    data = ownedBuffer.data();
+    dataSize = ownedBuffer.size();
+    reset();
 }
 
-void BitInputStream::setBuffer(const std::vector<uint8_t>& data) {
-    buffer = data;
-    byteIndex = 0;
-    bitIndex = 0;
+void BitInputStream::setBuffer(ByteSpan span) {
+    ownedBuffer.clear();
+    data = span.data();
+    dataSize = span.size();
+    reset();
 }
 
-bool BitInputStream::readBit() {
-    if (!hasMoreBits()) {
-        throw std::runtime_error("尝试读取超出缓冲区范围");
+uint64_t BitInputStream::loadTail(size_t byteIndex) const {
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; i++) {
+        size_t index = byteIndex + i;
+        value = (value << 8) | (index < dataSize ? data[index] : 0);
     }
+    return value;
+}
 
-    bool bit = (buffer[byteIndex] >> (7 - bitIndex)) & 1;
-    bitIndex++;
-
-    if (bitIndex == 8) {
-        byteIndex++;
-        bitIndex = 0;
+void BitInputStream::ensureBits(unsigned count) {
+    if (getRemainingBits() < count) {
+        throw std::runtime_error("尝试读取超出缓冲区范围");
+    }
+    if (containerBits < count) {
+        refill();
     }
+}
 
+bool BitInputStream::readBit() {
+    ensureBits(1);
+    bool bit = peek(1);
+    consume(1);
     return bit;
 }
 
@@ -139,65 +218,79 @@ std::vector<bool> BitInputStream::readBits(size_t count) {
 }
 
 uint8_t BitInputStream::readByte() {
-    if (byteIndex >= buffer.size()) {
-        throw std::runtime_error("尝试读取超出缓冲区范围");
-    }
-
-    if (bitIndex == 0) {
-        return buffer[byteIndex++];
-    } else {
-        if (byteIndex + 1 >= buffer.size()) {
-            throw std::runtime_error("读取字节时数据不足");
-        }
-        uint8_t highBits = buffer[byteIndex] & ((1 << (8 - bitIndex)) - 1);
-        uint8_t lowBits = buffer[byteIndex + 1] >> (8 - bitIndex);
-        byteIndex++;
-        return (highBits << bitIndex) | lowBits;
-    }
+    ensureBits(8);
+    uint8_t byte = static_cast<uint8_t>(peek(8));
+    consume(8);
+    return byte;
 }
 
 std::vector<uint8_t> BitInputStream::readBytes(size_t count) {
+    count = std::min(count, getRemainingBits() / 8);
+
+    // 字节对齐时直接复制
+    if (bitPosition % 8 == 0) {
+        const uint8_t* begin = data + bitPosition / 8;
+        std::vector<uint8_t> result(begin, begin + count);
+        bitPosition += count * 8;
+        containerBits = 0;
+        return result;
+    }
+
     std::vector<uint8_t> result;
     result.reserve(count);
-
     for (size_t i = 0; i < count; i++) {
-        if (byteIndex >= buffer.size()) {
-            break;
-        }
         result.push_back(readByte());
     }
-
     return result;
 }
 
 bool BitInputStream::hasMoreBits() const {
-    return byteIndex < buffer.size();
+    return bitPosition < dataSize * 8;
+}
+
+bool BitInputStream::isOverrun() const {
+    return bitPosition > dataSize * 8;
 }
 
 size_t BitInputStream::getRemainingBits() const {
-    if (byteIndex >= buffer.size()) {
+    if (bitPosition >= dataSize * 8) {
         return 0;
     }
-    return (buffer.size() - byteIndex) * 8 - bitIndex;
+    return dataSize * 8 - bitPosition;
 }
 
 size_t BitInputStream::getCurrentPosition() const {
-    return byteIndex * 8 + bitIndex;
+    return bitPosition;
+}
+
+const uint8_t* BitInputStream::getData() const {
+    return data;
 }
 
 size_t BitInputStream::getSize() const {
-    return buffer.size();
+    return dataSize;
+}
+
+void BitInputStream::seek(size_t position) {
+    if (position > dataSize * 8) {
+        throw std::runtime_error("尝试读取超出缓冲区范围");
+    }
+    bitPosition = position;
+    bitContainer = 0;
+    containerBits = 0;
 }
 
 void BitInputStream::reset() {
-    byteIndex = 0;
-    bitIndex = 0;
+    bitPosition = 0;
+    bitContainer = 0;
+    containerBits = 0;
 }
 
 void BitInputStream::clear() {
-    buffer.clear();
-    byteIndex = 0;
-    bitIndex = 0;
+    ownedBuffer.clear();
+    data = nullptr;
+    dataSize = 0;
+    reset();
 }
 
 }
\ No newline at end of file
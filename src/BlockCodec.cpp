@@ -0,0 +1,439 @@
+#include "BlockCodec.hpp"
+#include "Kernels.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace huffman {
+
+BlockCodec::BlockCodec() : treeWalkDecoding(false), useTreeWalk(false), streamCount(1) {}
+
+void BlockCodec::setMaxCodeLength(uint8_t length) {
+    huffmanTree.setMaxCodeLength(length);
+}
+
+void BlockCodec::setTreeWalkDecoding(bool enabled) {
+    treeWalkDecoding = enabled;
+}
+
+void BlockCodec::setStreamCount(size_t count) {
+    streamCount = count;
+}
+
+void BlockCodec::buildEncoder(ByteSpan data) {
+    huffmanTree.buildFromData(data);
+}
+
+void BlockCodec::buildEncoderParallel(ByteSpan data, ThreadPool& pool) {
+    if (data.empty()) {
+        throw std::invalid_argument("数据为空");
+    }
+
+    size_t chunkCount = pool.size() * 4;
+    size_t chunkSize = std::max(PARALLEL_CHUNK_SIZE, (data.size() + chunkCount - 1) / chunkCount);
+    chunkCount = (data.size() + chunkSize - 1) / chunkSize;
+
+    // 每段统计到各自的频率表，按顺序累加
+    const KernelTable& kernels = getKernels();
+    std::vector<std::future<Frequencies>> counted;
+    for (size_t i = 0; i < chunkCount; i++) {
+        size_t offset = i * chunkSize;
+        ByteSpan chunk = data.subspan(offset, std::min(chunkSize, data.size() - offset));
+        counted.push_back(pool.submit([&kernels, chunk]() {
+            Frequencies frequencies{};
+            kernels.histogram(chunk.data(), chunk.size(), frequencies.data());
+            return frequencies;
+        }));
+    }
+
+    Frequencies frequencies{};
+    for (auto& future : counted) {
+        Frequencies partial = future.get();
+        for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+            frequencies[symbol] += partial[symbol];
+        }
+    }
+
+    huffmanTree.buildFromFrequencies(frequencies);
+}
+
+auto BlockCodec::serializeTable() const -> std::vector<uint8_t> {
+    return huffmanTree.serializeLengths();
+}
+
+void BlockCodec::encode(ByteSpan data, BitOutputStream& bitStream) const {
+    // 编码表按字节直接索引，由当前指令集的内核分段写入输出缓冲区
+    const EncodeTable& encodeTable = huffmanTree.getEncodeTable();
+    unsigned maxLength = 0;
+    for (const CodeEntry& entry : encodeTable) {
+        maxLength = std::max<unsigned>(maxLength, entry.len);
+    }
+
+    const KernelTable& kernels = getKernels();
+    for (size_t offset = 0; offset < data.size(); offset += ENCODE_SLICE_SIZE) {
+        size_t size = std::min(ENCODE_SLICE_SIZE, data.size() - offset);
+        uint64_t bits;
+        unsigned count;
+        uint8_t* out = bitStream.beginDirect(size * maxLength / 8 + 8, bits, count);
+        size_t written = kernels.encode(encodeTable.data(), maxLength, data.data() + offset, size,
+            out, bits, count);
+        bitStream.endDirect(written, bits, count);
+    }
+}
+
+uint64_t BlockCodec::measureBits(ByteSpan data) const {
+    const EncodeTable& encodeTable = huffmanTree.getEncodeTable();
+    uint64_t bits = 0;
+    for (uint8_t byte : data) {
+        bits += encodeTable[byte].len;
+    }
+    return bits;
+}
+
+void BlockCodec::encodeParallel(ByteSpan data, std::vector<uint8_t>& output, ThreadPool& pool) const {
+    // 每个线程分几段，内容不均匀时负载更平衡
+    size_t chunkCount = pool.size() * 4;
+    size_t chunkSize = std::max(PARALLEL_CHUNK_SIZE, (data.size() + chunkCount - 1) / chunkCount);
+    chunkCount = (data.size() + chunkSize - 1) / chunkSize;
+
+    auto chunkAt = [&](size_t index) {
+        size_t offset = index * chunkSize;
+        return data.subspan(offset, std::min(chunkSize, data.size() - offset));
+    };
+
+    // 各段的编码位数，求前缀和得到每段的起始位偏移
+    std::vector<std::future<uint64_t>> measured;
+    for (size_t i = 0; i < chunkCount; i++) {
+        ByteSpan chunk = chunkAt(i);
+        measured.push_back(pool.submit([this, chunk]() { return measureBits(chunk); }));
+    }
+    std::vector<uint64_t> bitOffsets(chunkCount + 1, 0);
+    for (size_t i = 0; i < chunkCount; i++) {
+        bitOffsets[i + 1] = bitOffsets[i] + measured[i].get();
+    }
+
+    size_t payloadOffset = output.size();
+    output.resize(payloadOffset + (bitOffsets[chunkCount] + 7) / 8);
+    uint8_t* payload = output.data() + payloadOffset;
+
+    // 每段先补齐起始位偏移的字节内部分再编码，除首字节外直接写入各自的位置；
+    // 首字节可能与前一段的末字节重叠，全部完成后再按顺序合并
+    std::vector<std::future<uint8_t>> firstBytes;
+    for (size_t i = 0; i < chunkCount; i++) {
+        ByteSpan chunk = chunkAt(i);
+        uint64_t bitOffset = bitOffsets[i];
+        uint64_t bitCount = bitOffsets[i + 1] - bitOffset;
+        firstBytes.push_back(pool.submit([this, chunk, bitOffset, bitCount, payload]() -> uint8_t {
+            if (bitCount == 0) {
+                return 0;
+            }
+            BitOutputStream bitStream;
+            bitStream.reserve((bitOffset % 8 + bitCount + 7) / 8);
+            bitStream.writeBits(0, bitOffset % 8);
+            encode(chunk, bitStream);
+            std::vector<uint8_t> bytes = bitStream.takeBuffer();
+            std::memcpy(payload + bitOffset / 8 + 1, bytes.data() + 1, bytes.size() - 1);
+            return bytes[0];
+        }));
+    }
+    for (size_t i = 0; i < chunkCount; i++) {
+        uint8_t firstByte = firstBytes[i].get();
+        if (bitOffsets[i + 1] != bitOffsets[i]) {
+            payload[bitOffsets[i] / 8] |= firstByte;
+        }
+    }
+}
+
+void BlockCodec::buildDecoder(ByteSpan treeData, bool canonical) {
+    if (!canonical) { // 旧格式：前序遍历树
+        huffmanTree.deserialize(treeData);
+        useTreeWalk = true;
+    } else if (treeWalkDecoding) {
+        huffmanTree.buildFromLengths(HuffmanTree::deserializeLengths(treeData));
+        huffmanTree.rebuildTreeFromCodes();
+        useTreeWalk = true;
+    } else {
+        decoder.build(HuffmanTree::deserializeLengths(treeData));
+        useTreeWalk = false;
+    }
+}
+
+void BlockCodec::decode(BitInputStream& bitStream, uint8_t* output, size_t count) {
+    if (!useTreeWalk) {
+        if (decoder.isSingleSymbol()) { // 特殊情况：只有一个字符
+            std::fill_n(output, count, decoder.getFirstSymbol());
+        } else {
+            decoder.decode(bitStream, output, count);
+        }
+        return;
+    }
+
+    const HuffmanNode& root = huffmanTree.getNode(huffmanTree.getRoot());
+
+    if (root.isLeaf) { // 特殊情况：只有一个字符
+        std::fill_n(output, count, root.data);
+        return;
+    }
+
+    for (size_t index = 0; index < count; index++) {
+        output[index] = decodeTreeWalk(bitStream);
+    }
+}
+
+uint8_t BlockCodec::decodeTreeWalk(BitInputStream& bitStream) const {
+    const HuffmanNode* currentNode = &huffmanTree.getNode(huffmanTree.getRoot());
+    while (!currentNode->isLeaf) {
+        bool bit = bitStream.readBit();
+        uint16_t next = bit ? currentNode->right : currentNode->left;
+        if (next == NULL_NODE) {
+            throw std::runtime_error("无效的哈夫曼编码");
+        }
+        currentNode = &huffmanTree.getNode(next);
+    }
+    return currentNode->data;
+}
+
+uint8_t BlockCodec::decodeSymbol(BitInputStream& bitStream) const {
+    return useTreeWalk ? decodeTreeWalk(bitStream) : decoder.decodeSymbol(bitStream);
+}
+
+void BlockCodec::decodeRange(BitInputStream& bitStream, size_t endBit, size_t maxCount,
+    std::vector<uint8_t>& output, std::vector<size_t>& starts, size_t startCount) const {
+    // 前 startCount 个符号逐个解码并记录起始位置
+    while (starts.size() < startCount && output.size() < maxCount
+        && bitStream.getCurrentPosition() < endBit) {
+        starts.push_back(bitStream.getCurrentPosition());
+        output.push_back(decodeSymbol(bitStream));
+    }
+
+    if (useTreeWalk) {
+        while (output.size() < maxCount && bitStream.getCurrentPosition() < endBit) {
+            output.push_back(decodeTreeWalk(bitStream));
+        }
+        return;
+    }
+
+    // 输出长度事先未知，分段扩展输出缓冲区
+    constexpr size_t PIECE_SIZE = 64 * 1024;
+    while (output.size() < maxCount && bitStream.getCurrentPosition() < endBit) {
+        size_t index = output.size();
+        output.resize(index + std::min(PIECE_SIZE, maxCount - index));
+        size_t count = decoder.decodeUntil(bitStream, endBit, output.data() + index, output.size() - index);
+        output.resize(index + count);
+    }
+}
+
+void BlockCodec::decodeParallel(ByteSpan data, uint8_t* output, size_t count, ThreadPool& pool) const {
+    size_t chunkCount = pool.size() * 4;
+    size_t chunkSize = std::max(PARALLEL_CHUNK_SIZE, (data.size() + chunkCount - 1) / chunkCount);
+    chunkCount = (data.size() + chunkSize - 1) / chunkSize;
+    size_t totalBits = data.size() * 8;
+
+    auto chunkEnd = [&](size_t index) {
+        return std::min((index + 1) * chunkSize * 8, totalBits);
+    };
+
+    // 第一步：每段从自己的起始位置开始推测解码，直到下一个符号落在下一段中，
+    // 并记录前 PARALLEL_SYNC_SYMBOLS 个符号的起始位置。哈夫曼码通常很快自同步，
+    // 推测的符号边界在几个符号之后就会与真实边界重合
+    struct ChunkResult {
+        std::vector<uint8_t> symbols;
+        std::vector<size_t> starts;
+        size_t endBit = 0;
+    };
+
+    std::vector<std::future<ChunkResult>> results;
+    for (size_t i = 0; i < chunkCount; i++) {
+        size_t beginBit = i * chunkSize * 8;
+        size_t endBit = chunkEnd(i);
+        results.push_back(pool.submit([this, data, beginBit, endBit]() {
+            ChunkResult result;
+            try {
+                BitInputStream bitStream(data);
+                bitStream.seek(beginBit);
+                decodeRange(bitStream, endBit, SIZE_MAX, result.symbols, result.starts, PARALLEL_SYNC_SYMBOLS);
+                result.endBit = bitStream.getCurrentPosition();
+            } catch (const std::exception&) {
+                // 推测位置不是真实边界时可能读到无效编码或越过末尾，交给第二步重新解码
+                result.symbols.clear();
+                result.starts.clear();
+            }
+            return result;
+        }));
+    }
+
+    // 第二步：按顺序确定每段真实的起始位置，从这里逐个解码，直到某个符号的起始位置
+    // 出现在推测记录中：此后推测的结果与顺序解码相同。记录用完仍未重合时重新解码整段
+    size_t produced = 0;
+    size_t entryBit = 0;
+    std::vector<uint8_t> prefix;
+    std::vector<size_t> unusedStarts;
+    for (size_t i = 0; i < chunkCount && produced < count; i++) {
+        ChunkResult result = results[i].get();
+        size_t endBit = chunkEnd(i);
+
+        BitInputStream bitStream(data);
+        bitStream.seek(entryBit);
+        prefix.clear();
+
+        size_t skip = result.symbols.size();
+        size_t position = entryBit;
+        bool synced = false;
+        while (position < endBit && prefix.size() < count - produced) {
+            auto it = std::lower_bound(result.starts.begin(), result.starts.end(), position);
+            if (it == result.starts.end()) {
+                break;
+            }
+            if (*it == position) {
+                skip = it - result.starts.begin();
+                synced = true;
+                break;
+            }
+            prefix.push_back(decodeSymbol(bitStream));
+            position = bitStream.getCurrentPosition();
+        }
+
+        if (synced) {
+            entryBit = result.endBit;
+        } else {
+            if (position < endBit) {
+                decodeRange(bitStream, endBit, count - produced, prefix, unusedStarts, 0);
+            }
+            entryBit = bitStream.getCurrentPosition();
+        }
+
+        // 两部分都可能为空，空 vector 的 data() 可以是空指针，不能交给 memcpy
+        size_t n = std::min(prefix.size(), count - produced);
+        std::copy_n(prefix.begin(), n, output + produced);
+        produced += n;
+
+        n = std::min(result.symbols.size() - skip, count - produced);
+        std::copy_n(result.symbols.begin() + skip, n, output + produced);
+        produced += n;
+    }
+
+    if (produced < count) {
+        throw std::runtime_error("尝试读取超出缓冲区范围");
+    }
+}
+
+void BlockCodec::encodeBlock(ByteSpan block, std::vector<uint8_t>& output) {
+    buildEncoder(block);
+    std::vector<uint8_t> table = serializeTable();
+    // 只有一个字符时解码端直接填充，不需要压缩数据
+    bool singleSymbol = huffmanTree.getSymbolCount() == 1;
+    size_t jumpTableSize = (streamCount - 1) * sizeof(uint32_t);
+    size_t payloadSize = singleSymbol ? 0 : (huffmanTree.getStats().encodedBits + 7) / 8 + jumpTableSize;
+
+    BlockHeader blockHeader;
+    blockHeader.originalSize = static_cast<uint32_t>(block.size());
+
+    // 压缩后不比原数据小时直接存储
+    if (table.size() + payloadSize >= block.size()) {
+        blockHeader.flags = BLOCK_FLAG_RAW;
+        blockHeader.compressedSize = static_cast<uint32_t>(block.size());
+        output.insert(output.end(), reinterpret_cast<const uint8_t*>(&blockHeader),
+            reinterpret_cast<const uint8_t*>(&blockHeader) + BLOCK_HEADER_SIZE);
+        output.insert(output.end(), block.begin(), block.end());
+        return;
+    }
+
+    size_t headerOffset = output.size();
+    output.resize(headerOffset + BLOCK_HEADER_SIZE);
+    output.insert(output.end(), table.begin(), table.end());
+
+    if (!singleSymbol) {
+        // 跳转表先占位，各位流依次写入并按字节对齐
+        size_t jumpOffset = output.size();
+        output.resize(jumpOffset + jumpTableSize);
+        size_t streamOffset = output.size();
+
+        BitOutputStream bitStream(std::move(output));
+        bitStream.reserve(headerOffset + BLOCK_HEADER_SIZE + table.size() + payloadSize + streamCount);
+
+        size_t segment = (block.size() + streamCount - 1) / streamCount;
+        std::vector<uint32_t> streamSizes;
+        for (size_t i = 0; i < streamCount; i++) {
+            size_t begin = std::min(i * segment, block.size());
+            encode(block.subspan(begin, std::min(segment, block.size() - begin)), bitStream);
+            bitStream.flush();
+            size_t streamEnd = bitStream.getBitCount() / 8;
+            streamSizes.push_back(static_cast<uint32_t>(streamEnd - streamOffset));
+            streamOffset = streamEnd;
+        }
+        output = bitStream.takeBuffer();
+        std::memcpy(output.data() + jumpOffset, streamSizes.data(), jumpTableSize);
+    }
+
+    blockHeader.tableSize = static_cast<uint16_t>(table.size());
+    blockHeader.compressedSize = static_cast<uint32_t>(
+        output.size() - headerOffset - BLOCK_HEADER_SIZE - table.size());
+    std::memcpy(output.data() + headerOffset, &blockHeader, BLOCK_HEADER_SIZE);
+}
+
+void BlockCodec::decodeBlock(const BlockHeader& blockHeader, ByteSpan blockData, uint8_t* output) {
+    if (blockHeader.flags & BLOCK_FLAG_RAW) {
+        if (blockHeader.compressedSize != blockHeader.originalSize) {
+            throw std::runtime_error("块数据无效");
+        }
+        std::memcpy(output, blockData.data(), blockHeader.originalSize);
+        return;
+    }
+
+    buildDecoder(blockData.subspan(0, blockHeader.tableSize), true);
+    ByteSpan payload = blockData.subspan(blockHeader.tableSize, blockHeader.compressedSize);
+
+    if (streamCount == 1 || isSingleSymbol()) {
+        BitInputStream bitStream(payload);
+        decode(bitStream, output, blockHeader.originalSize);
+        return;
+    }
+
+    // 由跳转表划分各位流，最后一个位流占用剩余部分
+    size_t jumpTableSize = (streamCount - 1) * sizeof(uint32_t);
+    if (payload.size() < jumpTableSize) {
+        throw std::runtime_error("块数据无效");
+    }
+    uint32_t streamSizes[MAX_STREAM_COUNT] = {};
+    std::memcpy(streamSizes, payload.data(), jumpTableSize);
+
+    BitInputStream streams[MAX_STREAM_COUNT];
+    size_t offset = jumpTableSize;
+    for (size_t i = 0; i < streamCount; i++) {
+        size_t size = i + 1 < streamCount ? streamSizes[i] : payload.size() - offset;
+        if (size > payload.size() - offset) {
+            throw std::runtime_error("块数据无效");
+        }
+        streams[i].setBuffer(payload.subspan(offset, size));
+        offset += size;
+    }
+
+    if (useTreeWalk) {
+        size_t segment = (blockHeader.originalSize + streamCount - 1) / streamCount;
+        for (size_t i = 0; i < streamCount; i++) {
+            size_t begin = std::min<size_t>(i * segment, blockHeader.originalSize);
+            size_t end = std::min<size_t>(begin + segment, blockHeader.originalSize);
+            decode(streams[i], output + begin, end - begin);
+        }
+    } else {
+        decoder.decodeInterleaved(streams, streamCount, output, blockHeader.originalSize);
+    }
+}
+
+const HuffmanStats& BlockCodec::getStats() const {
+    return huffmanTree.getStats();
+}
+
+bool BlockCodec::isSingleSymbol() const {
+    if (useTreeWalk) {
+        return huffmanTree.getNode(huffmanTree.getRoot()).isLeaf;
+    }
+    return decoder.isSingleSymbol();
+}
+
+bool BlockCodec::isMultiSymbol() const {
+    return !useTreeWalk && decoder.isMultiSymbol();
+}
+
+}
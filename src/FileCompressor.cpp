@@ -1,27 +1,19 @@
 #include "FileCompressor.hpp"
 #include "BitStream.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
 #include <stdexcept>
 #include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <unistd.h>
 
 namespace huffman {
 
-std::vector<uint8_t> FileCompressor::readFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary | std::ios::ate);
-    if (!file) {
-        throw std::runtime_error("open file failed: " + filename);
-    }
-
-    std::streamsize size = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-    std::vector<uint8_t> buffer(size);
-    if (!file.read(reinterpret_cast<char*>(buffer.data()), size)) {
-        throw std::runtime_error("read file failed: " + filename);
-    }
-
-    return buffer;
-}
-
 void FileCompressor::writeFile(const std::string& filename, const std::vector<uint8_t>& data) {
     std::ofstream file(filename, std::ios::binary);
     if (!file) {
@@ -39,7 +31,7 @@ void FileCompressor::setHeader(uint16_t treeSize, uint64_t originalSize, uint64_
     header.compressedSize = compressedSize;
 }
 
-void FileCompressor::readHeader(const std::vector<uint8_t>& compressedData) {
+void FileCompressor::readHeader(ByteSpan compressedData) {
     if (compressedData.size() < HEADER_SIZE) {
         throw std::runtime_error("invalid compressed data");
     }
@@ -48,91 +40,636 @@ void FileCompressor::readHeader(const std::vector<uint8_t>& compressedData) {
     std::copy(compressedData.begin(), compressedData.begin() + HEADER_SIZE,
         reinterpret_cast<uint8_t*>(&header));
     
+    // 流式压缩的文件头不含大小，压缩数据为文件头之后的全部字节
+    if (header.magicNumber == MAGIC_NUMBER && (header.flags & FLAG_STREAM)) {
+        if (header.getFormatVersion() != FORMAT_V2 || header.treeSize != 0) {
+            throw std::runtime_error("invalid compressed data");
+        }
+        header.compressedSize = compressedData.size() - HEADER_SIZE;
+        return;
+    }
+
     // 检查数据是否有效
     if (header.magicNumber != MAGIC_NUMBER 
-        || header.treeSize + header.compressedSize + HEADER_SIZE > compressedData.size()) {
+        || size_t(header.treeSize) + HEADER_SIZE > compressedData.size()
+        || header.compressedSize > compressedData.size() - header.treeSize - HEADER_SIZE) {
         throw std::runtime_error("invalid compressed data");
     }
 }
 
-auto FileCompressor::compress(const std::vector<uint8_t>& originalData) -> std::vector<uint8_t> {
-    // 构建哈夫曼树
-    huffmanTree.buildFromData(originalData);
+auto FileCompressor::compress(ByteSpan originalData) -> std::vector<uint8_t> {
+    header = Header();
+    if (formatVersion == FORMAT_V1) {
+        return compressSingle(originalData);
+    }
+    return compressBlocks(originalData);
+}
 
-    // 序列化哈夫曼树
-    std::vector<uint8_t> treeData = huffmanTree.serialize();
+auto FileCompressor::compressSingle(ByteSpan originalData) -> std::vector<uint8_t> {
+    // 数据较大时分段多线程统计频率和编码
+    std::unique_ptr<ThreadPool> pool;
+    if (threadCount > 1 && originalData.size() >= 2 * PARALLEL_CHUNK_SIZE) {
+        pool = std::make_unique<ThreadPool>(threadCount);
+    }
 
-    // 压缩数据
-    BitOutputStream bitStream;
-    for (uint8_t byte : originalData) {
-        std::vector<bool> code = huffmanTree.getCode(byte);
-        bitStream.writeBits(code);
+    // 构建哈夫曼树
+    if (pool) {
+        codec.buildEncoderParallel(originalData, *pool);
+    } else {
+        codec.buildEncoder(originalData);
     }
-    bitStream.flush();
 
-    // 获取压缩后的内容
-    std::vector<uint8_t> compressedContent = bitStream.getBuffer();
+    const HuffmanStats& stats = codec.getStats();
+    if (verbose) {
+        double loss = stats.unlimitedBits == 0 ? 0.0
+            : 100.0 * (stats.encodedBits - stats.unlimitedBits) / stats.unlimitedBits;
+        std::cout << "最大码长: " << stats.depth
+                  << " (不限码长: " << stats.unlimitedDepth << ")"
+                  << ", 限长损失: " << loss << "%" << std::endl;
+    }
 
-    // 设置头信息
-    setHeader(treeData.size(), originalData.size(), compressedContent.size());
+    // 序列化码长表（范式编码）
+    std::vector<uint8_t> treeData = codec.serializeTable();
+    header.flags = FLAG_CANONICAL;
+
+    // 头信息和码长表先写入同一个输出流，压缩完成后再回填头信息
+    size_t payloadOffset = HEADER_SIZE + treeData.size();
+    BitOutputStream bitStream;
+    bitStream.reserve(payloadOffset + (stats.encodedBits + 7) / 8);
+    bitStream.writeBytes(reinterpret_cast<const uint8_t*>(&header), HEADER_SIZE);
+    bitStream.writeBytes(treeData);
 
-    // 构建压缩文件
+    // 压缩数据
     std::vector<uint8_t> compressedData;
+    if (pool) {
+        compressedData = bitStream.takeBuffer();
+        codec.encodeParallel(originalData, compressedData, *pool);
+    } else {
+        codec.encode(originalData, bitStream);
+        compressedData = bitStream.takeBuffer();
+    }
 
-    // 写入头信息
-    compressedData.insert(compressedData.end(), 
-        reinterpret_cast<const uint8_t*>(&header), 
-        reinterpret_cast<const uint8_t*>(&header) + sizeof(Header));
+    // 回填头信息
+    setHeader(treeData.size(), originalData.size(), compressedData.size() - payloadOffset);
+    std::copy(reinterpret_cast<const uint8_t*>(&header),
+        reinterpret_cast<const uint8_t*>(&header) + HEADER_SIZE, compressedData.begin());
 
-    // 写入哈夫曼树数据
-    compressedData.insert(compressedData.end(), treeData.begin(), treeData.end());
+    return compressedData;
+}
 
-    // 写入压缩后的内容
-    compressedData.insert(compressedData.end(),
-        compressedContent.begin(), compressedContent.end());
+auto FileCompressor::compressBlocks(ByteSpan originalData) -> std::vector<uint8_t> {
+    header.flags = FLAG_CANONICAL | (blockIndex ? FLAG_INDEX : 0);
+    header.setFormatVersion(FORMAT_V2);
+    header.setStreamCount(streamCount);
+    codec.setStreamCount(streamCount);
+
+    std::vector<uint8_t> compressedData(HEADER_SIZE);
+    compressedData.reserve(HEADER_SIZE + originalData.size() / 2);
+
+    size_t offset = 0;
+    auto nextBlock = [&](std::vector<uint8_t>&) {
+        ByteSpan block = originalData.subspan(offset, std::min(blockSize, originalData.size() - offset));
+        offset += block.size();
+        return block;
+    };
+    BlockStats stats = encodeBlocks(nextBlock, compressedData, []() {});
+
+    // 结束块
+    BlockHeader endBlock;
+    compressedData.insert(compressedData.end(), reinterpret_cast<const uint8_t*>(&endBlock),
+        reinterpret_cast<const uint8_t*>(&endBlock) + BLOCK_HEADER_SIZE);
+
+    if (verbose) {
+        std::cout << "分块: " << stats.blockCount << " x " << blockSize << " 字节"
+                  << ", 最大码长: " << stats.maxDepth
+                  << ", 压缩数据: " << (stats.encodedBits + 7) / 8 << " 字节" << std::endl;
+    }
+
+    // 回填头信息，压缩数据大小不含块索引
+    setHeader(0, originalData.size(), compressedData.size() - HEADER_SIZE);
+    std::copy(reinterpret_cast<const uint8_t*>(&header),
+        reinterpret_cast<const uint8_t*>(&header) + HEADER_SIZE, compressedData.begin());
+
+    if (blockIndex) {
+        appendBlockIndex(compressedData, stats);
+    }
 
     return compressedData;
 }
 
-auto FileCompressor::decompress(const std::vector<uint8_t>& compressedData) -> std::vector<uint8_t> {
-    // 获取头信息
-    setHeader(compressedData);
+void FileCompressor::appendBlockIndex(std::vector<uint8_t>& output, const BlockStats& stats) {
+    for (BlockIndexEntry entry : stats.index) {
+        entry.blockOffset += HEADER_SIZE;
+        output.insert(output.end(), reinterpret_cast<const uint8_t*>(&entry),
+            reinterpret_cast<const uint8_t*>(&entry) + INDEX_ENTRY_SIZE);
+    }
 
-    // 读取哈夫曼树
-    std::vector<uint8_t> treeData(compressedData.begin() + sizeof(Header),
-        compressedData.begin() + sizeof(Header) + header.treeSize);
-    huffmanTree.deserialize(treeData);
-    
-    // 读取压缩数据
-    std::vector<uint8_t> compressedContent(compressedData.begin() + sizeof(Header) + header.treeSize,
-        compressedData.end());
-    
-    // 解压数据
-    BitInputStream bitStream(compressedContent);
+    IndexTrailer trailer;
+    trailer.originalSize = stats.originalSize;
+    trailer.blockCount = stats.index.size();
+    output.insert(output.end(), reinterpret_cast<const uint8_t*>(&trailer),
+        reinterpret_cast<const uint8_t*>(&trailer) + INDEX_TRAILER_SIZE);
+}
+
+auto FileCompressor::encodeBlocks(const std::function<ByteSpan(std::vector<uint8_t>&)>& nextBlock,
+    std::vector<uint8_t>& output, const std::function<void()>& flush) -> BlockStats {
+    BlockStats stats;
+    auto addStats = [this, &stats](const HuffmanStats& blockStats, size_t originalSize, size_t compressedSize) {
+        if (blockIndex) {
+            stats.index.push_back({stats.originalSize, stats.compressedSize});
+        }
+        stats.encodedBits += blockStats.encodedBits;
+        stats.maxDepth = std::max<size_t>(stats.maxDepth, blockStats.depth);
+        stats.originalSize += originalSize;
+        stats.compressedSize += compressedSize;
+        stats.blockCount++;
+    };
+
+    if (threadCount <= 1) {
+        std::vector<uint8_t> buffer;
+        for (ByteSpan block = nextBlock(buffer); !block.empty(); block = nextBlock(buffer)) {
+            size_t start = output.size();
+            codec.encodeBlock(block, output);
+            addStats(codec.getStats(), block.size(), output.size() - start);
+            flush();
+        }
+        return stats;
+    }
+
+    // 每个任务使用独立的编解码器和输入缓冲区，结果按块的顺序追加，输出与线程数无关
+    struct EncodedBlock {
+        std::vector<uint8_t> data;
+        HuffmanStats stats;
+        size_t originalSize;
+    };
+
+    ThreadPool pool(threadCount);
+    std::deque<std::future<EncodedBlock>> pending;
+    auto appendBlock = [&]() {
+        EncodedBlock block = pending.front().get();
+        pending.pop_front();
+        output.insert(output.end(), block.data.begin(), block.data.end());
+        addStats(block.stats, block.originalSize, block.data.size());
+        flush();
+    };
+
+    while (true) {
+        std::vector<uint8_t> buffer;
+        ByteSpan block = nextBlock(buffer);
+        if (block.empty()) {
+            break;
+        }
+        pending.push_back(pool.submit([this, block, buffer = std::move(buffer)]() {
+            BlockCodec blockCodec;
+            blockCodec.setMaxCodeLength(maxCodeLength);
+            blockCodec.setStreamCount(streamCount);
+            EncodedBlock result;
+            blockCodec.encodeBlock(block, result.data);
+            result.stats = blockCodec.getStats();
+            result.originalSize = block.size();
+            return result;
+        }));
+
+        // 限制在途的块数，避免读入的数据和压缩结果堆积在内存中
+        if (pending.size() >= 2 * pool.size()) {
+            appendBlock();
+        }
+    }
+    while (!pending.empty()) {
+        appendBlock();
+    }
+
+    return stats;
+}
+
+void FileCompressor::compressStream(int inputFd, int outputFd) {
+    if (formatVersion != FORMAT_V2) {
+        throw std::invalid_argument("streaming compression requires the blocked format");
+    }
+
+    header = Header();
+    header.flags = FLAG_CANONICAL | FLAG_STREAM | (blockIndex ? FLAG_INDEX : 0);
+    header.setFormatVersion(FORMAT_V2);
+    header.setStreamCount(streamCount);
+    codec.setStreamCount(streamCount);
+
+    // 大小未知，文件头中的大小保持为 0
+    std::vector<uint8_t> output(reinterpret_cast<const uint8_t*>(&header),
+        reinterpret_cast<const uint8_t*>(&header) + HEADER_SIZE);
+
+    uint64_t compressedSize = 0;
+    auto nextBlock = [&](std::vector<uint8_t>& buffer) {
+        buffer.resize(blockSize);
+        size_t size = readFull(inputFd, buffer.data(), buffer.size());
+        return ByteSpan(buffer.data(), size);
+    };
+    auto flush = [&]() {
+        writeFull(outputFd, output.data(), output.size());
+        compressedSize += output.size();
+        output.clear();
+    };
+
+    BlockStats stats = encodeBlocks(nextBlock, output, flush);
+
+    // 结束块
+    BlockHeader endBlock;
+    output.insert(output.end(), reinterpret_cast<const uint8_t*>(&endBlock),
+        reinterpret_cast<const uint8_t*>(&endBlock) + BLOCK_HEADER_SIZE);
+    flush();
+    header.originalSize = stats.originalSize;
+    header.compressedSize = compressedSize - HEADER_SIZE;
+
+    // 块的位置在写出时已记下，索引可以直接追加在末尾
+    if (blockIndex) {
+        appendBlockIndex(output, stats);
+        flush();
+    }
+
+    // 标准输出可能就是压缩数据，详细信息写到标准错误
+    if (verbose) {
+        std::cerr << "分块: " << stats.blockCount << " x " << blockSize << " 字节"
+                  << ", 最大码长: " << stats.maxDepth
+                  << ", 原始数据: " << stats.originalSize << " 字节"
+                  << ", 压缩文件: " << compressedSize << " 字节" << std::endl;
+    }
+}
 
+auto FileCompressor::decompress(ByteSpan compressedData) -> std::vector<uint8_t> {
+    // 获取头信息
+    readHeader(compressedData);
+    if (header.getFormatVersion() == FORMAT_V1) {
+        return decompressSingle(compressedData);
+    }
+
+    // v2 与流式解压共用逐块解码，各块按顺序追加；
+    // 非流式压缩的原始大小已知，预先分配后追加不会重新分配，流式压缩的文件只能逐块增长
     std::vector<uint8_t> decompressedData;
-    decompressedData.reserve(header.originalSize);
+    if (!(header.flags & FLAG_STREAM)) {
+        decompressedData.reserve(header.originalSize);
+    }
+    decompressStream(compressedData, [&decompressedData](ByteSpan data) {
+        decompressedData.insert(decompressedData.end(), data.begin(), data.end());
+    });
+    return decompressedData;
+}
 
-    std::shared_ptr<HuffmanNode> currentNode = huffmanTree.getRoot();
+auto FileCompressor::decompressSingle(ByteSpan compressedData) -> std::vector<uint8_t> {
+    // 哈夫曼树和压缩数据都直接引用输入，不复制
+    ByteSpan treeData = compressedData.subspan(HEADER_SIZE, header.treeSize);
+    ByteSpan compressedContent = compressedData.subspan(HEADER_SIZE + header.treeSize,
+        header.compressedSize);
 
-    if (currentNode->isLeaf) { // 特殊情况：只有一个字符
-        decompressedData.resize(header.originalSize, currentNode->data);
+    codec.buildDecoder(treeData, header.flags & FLAG_CANONICAL);
+    if (verbose) {
+        std::cout << "解码表: " << (codec.isMultiSymbol() ? "多符号" : "单符号") << std::endl;
+    }
+
+    // 解压数据，数据较大时多线程推测解码
+    std::vector<uint8_t> decompressedData(header.originalSize);
+    if (threadCount > 1 && compressedContent.size() >= 2 * PARALLEL_CHUNK_SIZE && !codec.isSingleSymbol()) {
+        ThreadPool pool(threadCount);
+        codec.decodeParallel(compressedContent, decompressedData.data(), decompressedData.size(), pool);
     } else {
-        while (decompressedData.size() < header.originalSize && bitStream.hasMoreBits()) {
-            bool bit = bitStream.readBit();
-            if (bit) {
-                currentNode = currentNode->right;
+        BitInputStream bitStream(compressedContent);
+        codec.decode(bitStream, decompressedData.data(), decompressedData.size());
+    }
+
+    return decompressedData;
+}
+
+void FileCompressor::decompressStream(int inputFd, const std::function<void(ByteSpan)>& sink) {
+    header = Header();
+    if (readFull(inputFd, reinterpret_cast<uint8_t*>(&header), HEADER_SIZE) != HEADER_SIZE
+        || header.magicNumber != MAGIC_NUMBER) {
+        throw std::runtime_error("invalid compressed data");
+    }
+
+    // v1 只有一个位流，读入全部数据后整体解压
+    if (header.getFormatVersion() == FORMAT_V1) {
+        std::vector<uint8_t> compressedData(reinterpret_cast<const uint8_t*>(&header),
+            reinterpret_cast<const uint8_t*>(&header) + HEADER_SIZE);
+        size_t size = HEADER_SIZE;
+        do {
+            compressedData.resize(size + DEFAULT_BLOCK_SIZE);
+            size += readFull(inputFd, compressedData.data() + size, DEFAULT_BLOCK_SIZE);
+        } while (size == compressedData.size());
+        compressedData.resize(size);
+        sink(decompress(compressedData));
+        return;
+    }
+
+    // 块头和块数据读入各块自己的缓冲区
+    uint64_t outputSize = decodeBlocks([inputFd](BlockHeader& blockHeader, ByteSpan& data, std::vector<uint8_t>& storage) {
+        if (readFull(inputFd, reinterpret_cast<uint8_t*>(&blockHeader), BLOCK_HEADER_SIZE) != BLOCK_HEADER_SIZE) {
+            throw std::runtime_error("truncated compressed data");
+        }
+        if (blockHeader.originalSize == 0) { // 结束块
+            return false;
+        }
+
+        size_t blockDataSize = size_t(blockHeader.tableSize) + blockHeader.compressedSize;
+        if (blockDataSize > MAX_BLOCK_DATA_SIZE) {
+            throw std::runtime_error("invalid block header");
+        }
+        storage.resize(blockDataSize);
+        if (readFull(inputFd, storage.data(), blockDataSize) != blockDataSize) {
+            throw std::runtime_error("truncated compressed data");
+        }
+        data = storage;
+        return true;
+    }, sink);
+    checkOriginalSize(outputSize);
+}
+
+void FileCompressor::decompressStream(ByteSpan compressedData, const std::function<void(ByteSpan)>& sink) {
+    readHeader(compressedData);
+    if (header.getFormatVersion() == FORMAT_V1) {
+        sink(decompressSingle(compressedData));
+        return;
+    }
+
+    // 块数据直接引用输入，不复制
+    ByteSpan blocks = compressedData.subspan(HEADER_SIZE, header.compressedSize);
+    size_t offset = 0;
+    uint64_t outputSize = decodeBlocks([&blocks, &offset](BlockHeader& blockHeader, ByteSpan& data, std::vector<uint8_t>&) {
+        if (blocks.size() - offset < BLOCK_HEADER_SIZE) {
+            throw std::runtime_error("truncated compressed data");
+        }
+        std::memcpy(&blockHeader, blocks.data() + offset, BLOCK_HEADER_SIZE);
+        offset += BLOCK_HEADER_SIZE;
+        if (blockHeader.originalSize == 0) { // 结束块
+            return false;
+        }
+
+        size_t blockDataSize = size_t(blockHeader.tableSize) + blockHeader.compressedSize;
+        if (blockDataSize > blocks.size() - offset) {
+            throw std::runtime_error("truncated compressed data");
+        }
+        data = blocks.subspan(offset, blockDataSize);
+        offset += blockDataSize;
+        return true;
+    }, sink);
+    checkOriginalSize(outputSize);
+}
+
+auto FileCompressor::decompressRange(ByteSpan compressedData, uint64_t offset, uint64_t length)
+    -> std::vector<uint8_t> {
+    readHeader(compressedData);
+    uint64_t end = offset + std::min(length, std::numeric_limits<uint64_t>::max() - offset);
+
+    // v1 只有一个位流，无法从中间开始解码
+    if (header.getFormatVersion() == FORMAT_V1) {
+        std::vector<uint8_t> data = decompressSingle(compressedData);
+        if (offset > data.size()) {
+            throw std::out_of_range("range offset beyond end of data");
+        }
+        end = std::min<uint64_t>(end, data.size());
+        return std::vector<uint8_t>(data.begin() + offset, data.begin() + end);
+    }
+    if (header.getFormatVersion() != FORMAT_V2) {
+        throw std::runtime_error("unsupported format version");
+    }
+
+    auto readBlockHeader = [&compressedData](size_t position, BlockHeader& blockHeader) {
+        if (position > compressedData.size() || compressedData.size() - position < BLOCK_HEADER_SIZE) {
+            throw std::runtime_error("truncated compressed data");
+        }
+        std::memcpy(&blockHeader, compressedData.data() + position, BLOCK_HEADER_SIZE);
+    };
+
+    // 原始大小已知时（非流式压缩或带索引）先检查并截取范围
+    uint64_t originalSize = header.originalSize;
+    ByteSpan index = findBlockIndex(compressedData, originalSize);
+    if (!index.empty() || !(header.flags & FLAG_STREAM)) {
+        if (offset > originalSize) {
+            throw std::out_of_range("range offset beyond end of data");
+        }
+        end = std::min(end, originalSize);
+    }
+
+    // 定位覆盖 offset 的第一个块：blockStart 为其原始偏移，position 为其块头在文件中的位置
+    uint64_t blockStart = 0;
+    size_t position = HEADER_SIZE;
+    size_t firstBlock = 0;
+    if (!index.empty()) {
+        // 二分查找最后一个原始偏移不大于 offset 的块，索引项直接从输入中读取
+        auto entryAt = [&index](size_t i) {
+            BlockIndexEntry entry;
+            std::memcpy(&entry, index.data() + i * INDEX_ENTRY_SIZE, INDEX_ENTRY_SIZE);
+            return entry;
+        };
+        size_t low = 0;
+        size_t high = index.size() / INDEX_ENTRY_SIZE;
+        while (high - low > 1) {
+            size_t middle = low + (high - low) / 2;
+            if (entryAt(middle).originalOffset <= offset) {
+                low = middle;
             } else {
-                currentNode = currentNode->left;
+                high = middle;
+            }
+        }
+
+        BlockIndexEntry entry = entryAt(low);
+        if (entry.originalOffset > offset || entry.blockOffset < HEADER_SIZE) {
+            throw std::runtime_error("invalid block index");
+        }
+        blockStart = entry.originalOffset;
+        position = static_cast<size_t>(std::min<uint64_t>(entry.blockOffset, compressedData.size()));
+        firstBlock = low;
+    } else {
+        // 没有索引时逐个读取块头，跳过在 offset 之前结束的块，不解码
+        while (true) {
+            BlockHeader blockHeader;
+            readBlockHeader(position, blockHeader);
+            if (blockHeader.originalSize == 0) { // 结束块
+                if (blockStart < offset) {
+                    throw std::out_of_range("range offset beyond end of data");
+                }
+                break;
+            }
+            if (blockHeader.originalSize > offset - blockStart) {
+                break;
             }
-            if (currentNode->isLeaf) {
-                decompressedData.push_back(currentNode->data);
-                currentNode = huffmanTree.getRoot();
+            size_t blockDataSize = size_t(blockHeader.tableSize) + blockHeader.compressedSize;
+            if (blockDataSize > compressedData.size() - position - BLOCK_HEADER_SIZE) {
+                throw std::runtime_error("truncated compressed data");
             }
+            position += BLOCK_HEADER_SIZE + blockDataSize;
+            blockStart += blockHeader.originalSize;
+            firstBlock++;
         }
     }
 
-    return decompressedData;
+    std::vector<uint8_t> result;
+    if (offset == end) {
+        return result;
+    }
+    if (!index.empty() || !(header.flags & FLAG_STREAM)) {
+        result.reserve(end - offset);
+    }
+
+    // 标准输出可能就是解压数据，详细信息写到标准错误
+    if (verbose) {
+        std::cerr << "起始块: " << firstBlock << (index.empty() ? " (扫描块头)" : " (块索引)") << std::endl;
+    }
+
+    // 从起始块开始按顺序解码，到范围末尾为止；只保留各块落在范围内的部分
+    uint64_t sinkStart = blockStart;
+    auto sink = [&](ByteSpan data) {
+        uint64_t from = std::max(offset, sinkStart);
+        uint64_t to = std::min<uint64_t>(end, sinkStart + data.size());
+        if (from < to) {
+            result.insert(result.end(), data.begin() + (from - sinkStart), data.begin() + (to - sinkStart));
+        }
+        sinkStart += data.size();
+    };
+
+    bool firstHeader = true;
+    decodeBlocks([&](BlockHeader& blockHeader, ByteSpan& data, std::vector<uint8_t>&) {
+        if (blockStart >= end) {
+            return false;
+        }
+        readBlockHeader(position, blockHeader);
+        position += BLOCK_HEADER_SIZE;
+        if (blockHeader.originalSize == 0) { // 结束块，范围超出末尾
+            return false;
+        }
+
+        // 索引指向的块必须覆盖 offset
+        if (firstHeader && blockHeader.originalSize <= offset - blockStart) {
+            throw std::runtime_error("invalid block index");
+        }
+        firstHeader = false;
+
+        size_t blockDataSize = size_t(blockHeader.tableSize) + blockHeader.compressedSize;
+        if (blockDataSize > compressedData.size() - position) {
+            throw std::runtime_error("truncated compressed data");
+        }
+        data = compressedData.subspan(position, blockDataSize);
+        position += blockDataSize;
+        blockStart += blockHeader.originalSize;
+        return true;
+    }, sink);
+
+    return result;
+}
+
+ByteSpan FileCompressor::findBlockIndex(ByteSpan compressedData, uint64_t& originalSize) const {
+    if (!(header.flags & FLAG_INDEX) || compressedData.size() < HEADER_SIZE + INDEX_TRAILER_SIZE) {
+        return ByteSpan();
+    }
+
+    IndexTrailer trailer;
+    std::memcpy(&trailer, compressedData.data() + compressedData.size() - INDEX_TRAILER_SIZE, INDEX_TRAILER_SIZE);
+    size_t available = compressedData.size() - HEADER_SIZE - INDEX_TRAILER_SIZE;
+    if (trailer.magicNumber != INDEX_MAGIC
+        || trailer.blockCount > available / INDEX_ENTRY_SIZE
+        || (!(header.flags & FLAG_STREAM) && trailer.originalSize != header.originalSize)) {
+        throw std::runtime_error("invalid block index");
+    }
+
+    originalSize = trailer.originalSize;
+    size_t indexSize = static_cast<size_t>(trailer.blockCount) * INDEX_ENTRY_SIZE;
+    return compressedData.subspan(compressedData.size() - INDEX_TRAILER_SIZE - indexSize, indexSize);
+}
+
+uint64_t FileCompressor::decodeBlocks(
+    const std::function<bool(BlockHeader&, ByteSpan&, std::vector<uint8_t>&)>& nextBlock,
+    const std::function<void(ByteSpan)>& sink) {
+    if (header.getFormatVersion() != FORMAT_V2) {
+        throw std::runtime_error("unsupported format version");
+    }
+    size_t streams = header.getStreamCount();
+    if (streams > MAX_STREAM_COUNT || header.treeSize != 0) {
+        throw std::runtime_error("invalid compressed data");
+    }
+    codec.setStreamCount(streams);
+    bool streamed = header.flags & FLAG_STREAM;
+
+    // 块的原始大小不超过分块大小上限，以此限制单块的内存占用
+    uint64_t outputSize = 0;
+    auto readBlock = [&](BlockHeader& blockHeader, ByteSpan& data, std::vector<uint8_t>& storage) {
+        if (!nextBlock(blockHeader, data, storage)) {
+            return false;
+        }
+        if (blockHeader.originalSize > MAX_BLOCK_SIZE
+            || (!streamed && blockHeader.originalSize > header.originalSize - outputSize)) {
+            throw std::runtime_error("invalid block header");
+        }
+        outputSize += blockHeader.originalSize;
+        return true;
+    };
+
+    struct DecodedBlock {
+        std::vector<uint8_t> data;
+        bool multiSymbol;
+    };
+    auto decodeBlock = [](BlockCodec& blockCodec, const BlockHeader& blockHeader, ByteSpan data) {
+        DecodedBlock result;
+        result.data.resize(blockHeader.originalSize);
+        blockCodec.decodeBlock(blockHeader, data, result.data.data());
+        result.multiSymbol = blockCodec.isMultiSymbol() && !(blockHeader.flags & BLOCK_FLAG_RAW);
+        return result;
+    };
+
+    size_t blockCount = 0;
+    size_t multiCount = 0;
+    auto emitBlock = [&](const DecodedBlock& block) {
+        sink(block.data);
+        multiCount += block.multiSymbol;
+        blockCount++;
+    };
+
+    BlockHeader blockHeader;
+    ByteSpan data;
+    std::vector<uint8_t> storage;
+    if (threadCount <= 1) {
+        while (readBlock(blockHeader, data, storage)) {
+            emitBlock(decodeBlock(codec, blockHeader, data));
+        }
+    } else {
+        // 读取按顺序进行，解码交给线程池，最多 2 × 线程数个块在途；
+        // 块数据在各自的缓冲区中时随任务一起移交，移动后数据地址不变
+        ThreadPool pool(threadCount);
+        std::deque<std::future<DecodedBlock>> pending;
+        auto collectBlock = [&]() {
+            emitBlock(pending.front().get());
+            pending.pop_front();
+        };
+
+        while (readBlock(blockHeader, data, storage)) {
+            pending.push_back(pool.submit(
+                [this, streams, blockHeader, data, storage = std::move(storage), &decodeBlock]() {
+                    BlockCodec blockCodec;
+                    blockCodec.setTreeWalkDecoding(treeWalkDecoding);
+                    blockCodec.setStreamCount(streams);
+                    return decodeBlock(blockCodec, blockHeader, data);
+                }));
+            storage = std::vector<uint8_t>();
+
+            if (pending.size() >= 2 * pool.size()) {
+                collectBlock();
+            }
+        }
+        while (!pending.empty()) {
+            collectBlock();
+        }
+    }
+
+    // 标准输出可能就是解压数据，详细信息写到标准错误
+    if (verbose) {
+        std::cerr << "分块: " << blockCount << ", 多符号解码表: " << multiCount << std::endl;
+    }
+
+    return outputSize;
+}
+
+void FileCompressor::checkOriginalSize(uint64_t outputSize) {
+    if (header.flags & FLAG_STREAM) {
+        header.originalSize = outputSize;
+    } else if (outputSize != header.originalSize) {
+        throw std::runtime_error("decompressed size mismatch");
+    }
 }
 
 void FileCompressor::compressToFile(const std::vector<uint8_t>& originalData, const std::string& output) {
@@ -143,16 +680,87 @@ void FileCompressor::compressToFile(const std::vector<uint8_t>& originalData, co
     writeFile(output, compressedData);
 }
 
-void FileCompressor::decompressFromFile(const std::string& input, std::vector<uint8_t>& decompressedData) {
-    // 读取压缩文件
-    std::vector<uint8_t> compressedData = readFile(input);
+size_t FileCompressor::readFull(int fd, uint8_t* data, size_t size) {
+    size_t total = 0;
+    while (total < size) {
+        ssize_t count = ::read(fd, data + total, size - total);
+        if (count == 0) {
+            break;
+        }
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("read failed: ") + std::strerror(errno));
+        }
+        total += static_cast<size_t>(count);
+    }
+    return total;
+}
+
+void FileCompressor::writeFull(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t count = ::write(fd, data, size);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("write failed: ") + std::strerror(errno));
+        }
+        data += count;
+        size -= static_cast<size_t>(count);
+    }
+}
+
+const Header& FileCompressor::getHeader() const {
+    return header;
+}
+
+void FileCompressor::setVerbose(bool verbose) {
+    this->verbose = verbose;
+}
+
+void FileCompressor::setMaxCodeLength(uint8_t length) {
+    maxCodeLength = length;
+    codec.setMaxCodeLength(length);
+}
+
+void FileCompressor::setBlockSize(size_t size) {
+    if (size < MIN_BLOCK_SIZE || size > MAX_BLOCK_SIZE) {
+        throw std::invalid_argument("block size out of range");
+    }
+    blockSize = size;
+}
+
+void FileCompressor::setThreadCount(size_t count) {
+    threadCount = count == 0 ? ThreadPool::hardwareThreads() : count;
+}
+
+void FileCompressor::setStreamCount(size_t count) {
+    if (count != 1 && count != 4) {
+        throw std::invalid_argument("unsupported stream count");
+    }
+    streamCount = count;
+}
+
+void FileCompressor::setFormatVersion(uint16_t version) {
+    if (version != FORMAT_V1 && version != FORMAT_V2) {
+        throw std::invalid_argument("unsupported format version");
+    }
+    formatVersion = version;
+}
+
+void FileCompressor::setBlockIndex(bool enabled) {
+    blockIndex = enabled;
+}
 
-    // 解压数据
-    decompressedData = decompress(compressedData);
+void FileCompressor::setTreeWalkDecoding(bool enabled) {
+    treeWalkDecoding = enabled;
+    codec.setTreeWalkDecoding(enabled);
 }
 
 void FileCompressor::clear() {
-    huffmanTree.clear();
+    header = Header();
 }
 
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #include "HuffmanArchiver.hpp"
+#include "MappedFile.hpp"
+#include "StreamUnpacker.hpp"
+#include <algorithm>
 #include <iostream>
 #include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
@@ -9,14 +14,63 @@ namespace huffman {
 constexpr const char* VERSION = "1.0.0";
 constexpr const char* FILE_EXTENSION = ".huff";
 
+namespace {
+
+// 出错返回时关闭已打开的文件描述符
+struct FileCloser {
+    int fd = -1;
+    ~FileCloser() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    // 正常结束时关闭，返回是否成功
+    bool close() {
+        int closing = fd;
+        fd = -1;
+        return ::close(closing) == 0;
+    }
+};
+
+}
+
 HuffmanArchiver::HuffmanArchiver()
     : packer(std::make_unique<Packer>())
     , fileCompressor(std::make_unique<FileCompressor>())
 {}
 
 void HuffmanArchiver::setVerbose(bool verbose) {
-    packer.setVerbose(verbose);
-    fileCompressor.setVerbose(verbose);
+    packer->setVerbose(verbose);
+    fileCompressor->setVerbose(verbose);
+}
+
+void HuffmanArchiver::setMaxCodeLength(uint8_t length) {
+    fileCompressor->setMaxCodeLength(length);
+}
+
+void HuffmanArchiver::setBlockSize(size_t size) {
+    fileCompressor->setBlockSize(size);
+}
+
+void HuffmanArchiver::setStreamCount(size_t count) {
+    fileCompressor->setStreamCount(count);
+}
+
+void HuffmanArchiver::setThreadCount(size_t count) {
+    fileCompressor->setThreadCount(count);
+}
+
+void HuffmanArchiver::setLegacyFormat(bool enabled) {
+    fileCompressor->setFormatVersion(enabled ? FORMAT_V1 : FORMAT_V2);
+}
+
+void HuffmanArchiver::setBlockIndex(bool enabled) {
+    fileCompressor->setBlockIndex(enabled);
+}
+
+void HuffmanArchiver::setTreeWalkDecoding(bool enabled) {
+    fileCompressor->setTreeWalkDecoding(enabled);
 }
 
 std::string HuffmanArchiver::getExtension(const std::string& path) {
@@ -64,27 +118,75 @@ bool HuffmanArchiver::compress(const std::vector<std::string>& sources, const st
     }
 }
 
+bool HuffmanArchiver::compressStream(const std::string& output) {
+    FileCloser closer;
+
+    try {
+        int outputFd = STDOUT_FILENO;
+        if (!output.empty() && output != "-") {
+            // 标准输入是待压缩的数据，无法询问是否覆盖
+            if (fs::exists(output)) {
+                std::cerr << "ERORR: 输出文件已存在: " << output << std::endl;
+                return false;
+            }
+            closer.fd = ::open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (closer.fd < 0) {
+                std::cerr << "ERORR: 创建文件失败: " << output << std::endl;
+                return false;
+            }
+            outputFd = closer.fd;
+        } else if (::isatty(STDOUT_FILENO)) {
+            std::cerr << "ERORR: 压缩数据不能写到终端，请重定向标准输出或使用 -o 指定输出文件" << std::endl;
+            return false;
+        }
+
+        fileCompressor->compressStream(STDIN_FILENO, outputFd);
+
+        if (closer.fd >= 0 && !closer.close()) {
+            std::cerr << "ERORR: 写入文件失败: " << output << std::endl;
+            return false;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "ERORR: " << e.what() << std::endl;
+        return false;
+    }
+}
+
 bool HuffmanArchiver::decompress(const std::string& source,
                                  const std::string& output) {
+    FileCloser inputCloser;
+    FileCloser outputCloser;
+
     try {
-        if (!fs::exists(source)) {
+        // "-" 表示从标准输入读取压缩数据
+        bool fromStdin = source == "-";
+        if (!fromStdin && !fs::exists(source)) {
             std::cerr << "ERORR: 压缩文件不存在: " << source << std::endl;
             return false;
         }
 
-        // 确定输出路径
+        // 确定输出路径，"-" 表示写到标准输出
         std::string actualOutput = output;
         if (actualOutput.empty()) {
-            // 如果源文件有.huff扩展名，移除它
-            if (getExtension(source) == FILE_EXTENSION) {
+            if (fromStdin) {
+                actualOutput = "-";
+            } else if (getExtension(source) == FILE_EXTENSION) {
+                // 如果源文件有.huff扩展名，移除它
                 actualOutput = removeExtension(source);
             } else {
                 actualOutput = source + "_extracted";
             }
         }
+        bool toStdout = actualOutput == "-";
 
         // 检查输出路径是否已存在
-        if (fs::exists(actualOutput)) {
+        if (!toStdout && fs::exists(actualOutput)) {
+            // 标准输入是压缩数据，无法询问是否覆盖
+            if (fromStdin) {
+                std::cerr << "ERORR: 输出路径已存在: " << actualOutput << std::endl;
+                return false;
+            }
             std::cout << "WARNNING: 输出路径已存在: " << actualOutput
                 << "\n是否确认覆盖? (y/n): ";
             char confirm;
@@ -94,13 +196,65 @@ bool HuffmanArchiver::decompress(const std::string& source,
             }
         }
 
-        // 从文件解压数据
-        std::vector<uint8_t> packedData;
-        fileCompressor->decompressFromFile(source, packedData);
+        // 读到文件头后才知道内容是单个字节流还是打包的目录项，在第一块数据到达前决定输出方式
+        std::unique_ptr<StreamUnpacker> unpacker;
+        int outputFd = -1;
+        auto openOutput = [&]() {
+            if (unpacker || outputFd >= 0) {
+                return;
+            }
+            if (!(fileCompressor->getHeader().flags & FLAG_STREAM)) {
+                if (toStdout) {
+                    throw std::runtime_error("打包的文件或目录不能解压到标准输出，请使用 -o 指定输出目录");
+                }
+                unpacker = std::make_unique<StreamUnpacker>(actualOutput);
+            } else if (toStdout) {
+                outputFd = STDOUT_FILENO;
+            } else {
+                outputCloser.fd = ::open(actualOutput.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (outputCloser.fd < 0) {
+                    throw std::runtime_error("创建文件失败: " + actualOutput);
+                }
+                outputFd = outputCloser.fd;
+            }
+        };
+
+        // 逐块解压，解出的数据立即写出
+        auto sink = [&](ByteSpan data) {
+            openOutput();
+            if (unpacker) {
+                unpacker->write(data);
+            } else {
+                FileCompressor::writeFull(outputFd, data.data(), data.size());
+            }
+        };
+
+        if (!fromStdin && fs::is_regular_file(source)) {
+            // 普通文件映射后直接从页面解码，省去一次复制
+            MappedFile file(source);
+            file.adviseSequential();
+            fileCompressor->decompressStream(file.data(), sink);
+        } else {
+            int inputFd = STDIN_FILENO;
+            if (!fromStdin) {
+                inputCloser.fd = ::open(source.c_str(), O_RDONLY);
+                if (inputCloser.fd < 0) {
+                    throw std::runtime_error("打开文件失败: " + source);
+                }
+                inputFd = inputCloser.fd;
+            }
+            fileCompressor->decompressStream(inputFd, sink);
+        }
+
+        openOutput();
+        if (unpacker) {
+            unpacker->finish();
+        }
+        if (outputCloser.fd >= 0 && !outputCloser.close()) {
+            std::cerr << "ERORR: 写入文件失败: " << actualOutput << std::endl;
+            return false;
+        }
 
-        // 解包数据
-        packer->unpack(packedData, actualOutput);
-        
         return true;
 
     } catch (const std::exception& e) {
@@ -109,6 +263,78 @@ bool HuffmanArchiver::decompress(const std::string& source,
     }
 }
 
+bool HuffmanArchiver::decompressRange(const std::string& source, uint64_t offset, uint64_t length,
+                                      const std::string& output) {
+    FileCloser outputCloser;
+
+    try {
+        if (!fs::is_regular_file(source)) {
+            std::cerr << "ERORR: 按范围解压需要可随机访问的压缩文件: " << source << std::endl;
+            return false;
+        }
+
+        MappedFile file(source);
+        file.adviseRandom();
+
+        // 打包的单个文件：范围以文件内容为准，偏移加上目录项头部的长度；
+        // 打包的目录或多个文件没有统一的偏移，不支持按范围解压
+        fileCompressor->readHeader(file.data());
+        if (!(fileCompressor->getHeader().flags & FLAG_STREAM)) {
+            std::vector<uint8_t> prefix = fileCompressor->decompressRange(file.data(), 0, Packer::MAX_FILE_HEADER_SIZE);
+            uint64_t contentOffset = 0;
+            uint64_t fileSize = 0;
+            bool singleFile = Packer::parseFileHeader(prefix, contentOffset, fileSize);
+            if (singleFile) {
+                std::vector<uint8_t> next = fileCompressor->decompressRange(file.data(), contentOffset + fileSize, 1);
+                singleFile = next.size() == 1 && next[0] == static_cast<uint8_t>(EntryType::END);
+            }
+            if (!singleFile) {
+                std::cerr << "ERORR: 只有单个文件或流式压缩的文件可以按范围解压，"
+                    "请用 compress - --index 从标准输入压缩" << std::endl;
+                return false;
+            }
+            if (offset > fileSize) {
+                std::cerr << "ERORR: 起始偏移超出文件末尾: " << offset << std::endl;
+                return false;
+            }
+            length = std::min(length, fileSize - offset);
+            offset += contentOffset;
+        }
+
+        // 先解压再创建输出文件，范围无效时不留下空文件
+        std::vector<uint8_t> data = fileCompressor->decompressRange(file.data(), offset, length);
+
+        int outputFd = STDOUT_FILENO;
+        if (!output.empty() && output != "-") {
+            if (fs::exists(output)) {
+                std::cout << "WARNNING: 输出文件已存在: " << output
+                    << "\n是否确认覆盖? (y/n): ";
+                char confirm;
+                std::cin >> confirm;
+                if (confirm != 'y' && confirm != 'Y') {
+                    return false;
+                }
+            }
+            outputCloser.fd = ::open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (outputCloser.fd < 0) {
+                std::cerr << "ERORR: 创建文件失败: " << output << std::endl;
+                return false;
+            }
+            outputFd = outputCloser.fd;
+        }
+
+        FileCompressor::writeFull(outputFd, data.data(), data.size());
+        if (outputCloser.fd >= 0 && !outputCloser.close()) {
+            std::cerr << "ERORR: 写入文件失败: " << output << std::endl;
+            return false;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "ERORR: " << e.what() << std::endl;
+        return false;
+    }
+}
+
 std::string HuffmanArchiver::getVersion() {
     return VERSION;
 }
@@ -0,0 +1,330 @@
+#include "HuffmanDecoder.hpp"
+#include "Kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace huffman {
+
+HuffmanDecoder::HuffmanDecoder()
+    : lengthCount{}, sortedSymbols{}, symbolCount(0), maxLength(0)
+    , tableBits(0), tableReady(false) {}
+
+void HuffmanDecoder::clear() {
+    lengthCount.fill(0);
+    sortedSymbols.fill(0);
+    symbolCount = 0;
+    maxLength = 0;
+    primaryTable.clear();
+    secondaryTable.clear();
+    multiTable.clear();
+    tableBits = 0;
+    tableReady = false;
+}
+
+void HuffmanDecoder::build(const CodeLengths& lengths) {
+    clear();
+
+    for (uint8_t len : lengths) {
+        if (len == 0) continue;
+        lengthCount[len]++;
+        maxLength = std::max(maxLength, len);
+    }
+
+    // 计算每种码长在排序表中的起始位置
+    std::array<uint16_t, MAX_CODE_LENGTH + 1> offsets{};
+    for (size_t len = 1; len < MAX_CODE_LENGTH; len++) {
+        offsets[len + 1] = offsets[len] + lengthCount[len];
+    }
+
+    // 按码长、符号值排序
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        if (lengths[symbol] != 0) {
+            sortedSymbols[offsets[lengths[symbol]]++] = static_cast<uint8_t>(symbol);
+            symbolCount++;
+        }
+    }
+
+    if (symbolCount == 0) {
+        throw std::invalid_argument("码长表为空");
+    }
+
+    buildTables(lengths);
+}
+
+void HuffmanDecoder::buildTables(const CodeLengths& lengths) {
+    tableBits = std::min(maxLength, DECODE_TABLE_BITS);
+
+    // 计算范式码字
+    std::array<uint64_t, MAX_CODE_LENGTH + 1> nextCode{};
+    uint64_t code = 0;
+    for (size_t len = 1; len <= maxLength; len++) {
+        code = (code + lengthCount[len - 1]) << 1;
+        nextCode[len] = code;
+    }
+    std::array<uint32_t, SYMBOL_COUNT> codes{};
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        if (lengths[symbol] != 0) {
+            codes[symbol] = static_cast<uint32_t>(nextCode[lengths[symbol]]++);
+        }
+    }
+
+    // 统计每个长码前缀所需的二级表位数
+    primaryTable.assign(size_t(1) << tableBits, DecodeEntry{0, 0, 0});
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        uint8_t len = lengths[symbol];
+        if (len > tableBits) {
+            DecodeEntry& entry = primaryTable[codes[symbol] >> (len - tableBits)];
+            entry.subBits = std::max<uint8_t>(entry.subBits, len - tableBits);
+        }
+    }
+
+    // 分配二级表
+    size_t secondarySize = 0;
+    for (DecodeEntry& entry : primaryTable) {
+        if (entry.subBits != 0) {
+            entry.value = static_cast<uint16_t>(secondarySize);
+            secondarySize += size_t(1) << entry.subBits;
+            if (secondarySize > UINT16_MAX) { // 二级表过大，保留逐位解码
+                primaryTable.clear();
+                return;
+            }
+        }
+    }
+    secondaryTable.assign(secondarySize, DecodeEntry{0, 0, 0});
+
+    // 填充查找表：码字后面未使用的位取任意值都对应同一个符号
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        uint8_t len = lengths[symbol];
+        if (len == 0) continue;
+
+        DecodeEntry leaf{static_cast<uint16_t>(symbol), len, 0};
+        if (len <= tableBits) {
+            size_t first = size_t(codes[symbol]) << (tableBits - len);
+            size_t count = size_t(1) << (tableBits - len);
+            std::fill_n(primaryTable.begin() + first, count, leaf);
+        } else {
+            const DecodeEntry& entry = primaryTable[codes[symbol] >> (len - tableBits)];
+            uint8_t restBits = len - tableBits;
+            size_t suffix = codes[symbol] & ((uint32_t(1) << restBits) - 1);
+            size_t first = entry.value + (suffix << (entry.subBits - restBits));
+            size_t count = size_t(1) << (entry.subBits - restBits);
+            std::fill_n(secondaryTable.begin() + first, count, leaf);
+        }
+    }
+
+    tableReady = true;
+    buildMultiTable(lengths);
+}
+
+// 多符号表与一级表使用相同的索引位数：
+// 从预读窗口开头起反复查一级表，只要码字完全落在窗口内就继续解出下一个符号，
+// 窗口末尾补的 0 只影响超出窗口的码字，不会改变已解出的符号
+
+void HuffmanDecoder::buildMultiTable(const CodeLengths& lengths) {
+    // 以 2^-len 作为符号出现概率的估计，计算平均码长；
+    // 平均每次查表能解出两个以上符号时才值得构建
+    double averageLength = 0;
+    for (uint8_t len : lengths) {
+        if (len != 0) {
+            averageLength += std::ldexp(len, -len);
+        }
+    }
+    if (averageLength * 2 > tableBits) {
+        return;
+    }
+
+    size_t tableSize = size_t(1) << tableBits;
+    size_t tableMask = tableSize - 1;
+    multiTable.assign(tableSize, MultiDecodeEntry{{0, 0, 0, 0}, 0, 0});
+
+    for (size_t window = 0; window < tableSize; window++) {
+        MultiDecodeEntry& multi = multiTable[window];
+        while (multi.count < MULTI_SYMBOL_COUNT) {
+            const DecodeEntry& entry = primaryTable[(window << multi.bits) & tableMask];
+            if (entry.length == 0 || multi.bits + entry.length > tableBits) {
+                break;
+            }
+            multi.symbols[multi.count++] = static_cast<uint8_t>(entry.value);
+            multi.bits += entry.length;
+        }
+    }
+}
+
+inline uint8_t HuffmanDecoder::decodeOne(BitInputStream& bitStream) const {
+    DecodeEntry entry = primaryTable[bitStream.peek(tableBits)];
+    if (entry.length == 0 && entry.subBits != 0) {
+        uint32_t bits = bitStream.peek(tableBits + entry.subBits);
+        entry = secondaryTable[entry.value + (bits & ((uint32_t(1) << entry.subBits) - 1))];
+    }
+    if (entry.length == 0) {
+        throw std::runtime_error("无效的哈夫曼编码");
+    }
+
+    bitStream.consume(entry.length);
+    return static_cast<uint8_t>(entry.value);
+}
+
+uint8_t HuffmanDecoder::decodeSymbol(BitInputStream& bitStream) const {
+    if (!tableReady) {
+        return decodeSerial(bitStream);
+    }
+
+    bitStream.refill();
+    return decodeOne(bitStream);
+}
+
+DecodeTables HuffmanDecoder::kernelTables() const {
+    DecodeTables tables;
+    tables.primary = primaryTable.data();
+    tables.secondary = secondaryTable.data();
+    tables.multi = multiTable.empty() ? nullptr : multiTable.data();
+    tables.tableBits = tableBits;
+    tables.maxLength = maxLength;
+    return tables;
+}
+
+void HuffmanDecoder::decode(BitInputStream& bitStream, uint8_t* output, size_t count) const {
+    if (!tableReady) {
+        for (size_t index = 0; index < count; index++) {
+            output[index] = decodeSerial(bitStream);
+        }
+        return;
+    }
+
+    size_t position = getKernels().decode(kernelTables(), bitStream.getData(), bitStream.getSize(),
+        bitStream.getCurrentPosition(), output, count);
+    if (position == DECODE_INVALID) {
+        throw std::runtime_error("无效的哈夫曼编码");
+    }
+    if (position > bitStream.getSize() * 8) {
+        throw std::runtime_error("尝试读取超出缓冲区范围");
+    }
+    bitStream.seek(position);
+}
+
+void HuffmanDecoder::decodeInterleaved(BitInputStream* streams, size_t streamCount,
+    uint8_t* output, size_t count) const {
+    size_t segment = (count + streamCount - 1) / streamCount;
+    auto segmentBegin = [&](size_t index) { return std::min(index * segment, count); };
+
+    if (!tableReady || streamCount % 4 != 0) {
+        for (size_t i = 0; i < streamCount; i++) {
+            decode(streams[i], output + segmentBegin(i), segmentBegin(i + 1) - segmentBegin(i));
+        }
+        return;
+    }
+
+    DecodeTables tables = kernelTables();
+    const KernelTable& kernels = getKernels();
+
+    for (size_t group = 0; group < streamCount; group += 4) {
+        const uint8_t* data[4];
+        size_t sizes[4];
+        size_t positions[4];
+        uint8_t* outputs[4];
+        size_t indices[4] = {0, 0, 0, 0};
+        for (size_t i = 0; i < 4; i++) {
+            data[i] = streams[group + i].getData();
+            sizes[i] = streams[group + i].getSize();
+            positions[i] = streams[group + i].getCurrentPosition();
+            outputs[i] = output + segmentBegin(group + i);
+        }
+
+        // 组内最后一段最短，按它的长度同步推进 4 条解码链
+        size_t shortest = segmentBegin(group + 4) - segmentBegin(group + 3);
+        if (!kernels.decode4(tables, data, sizes, positions, outputs, indices, shortest)) {
+            throw std::runtime_error("无效的哈夫曼编码");
+        }
+
+        // 各段剩余的部分分别解码，同时检查是否越界
+        for (size_t i = 0; i < 4; i++) {
+            size_t length = segmentBegin(group + i + 1) - segmentBegin(group + i);
+            if (positions[i] > sizes[i] * 8) {
+                throw std::runtime_error("尝试读取超出缓冲区范围");
+            }
+            streams[group + i].seek(positions[i]);
+            decode(streams[group + i], outputs[i] + indices[i], length - indices[i]);
+        }
+    }
+}
+
+size_t HuffmanDecoder::decodeUntil(BitInputStream& bitStream, size_t endBit,
+    uint8_t* output, size_t maxCount) const {
+    size_t index = 0;
+
+    if (!tableReady) {
+        while (index < maxCount && bitStream.getCurrentPosition() < endBit) {
+            output[index++] = decodeSerial(bitStream);
+        }
+        return index;
+    }
+
+    // 一批查表中每次最多消耗 batchBits / steps 位，整批的符号都从 endBit 之前开始时，
+    // 批内不再逐个检查位置
+    size_t steps = MIN_REFILL_BITS / maxLength;
+    size_t batchBits = steps * std::max(maxLength, tableBits);
+    size_t batchSymbols = steps * (multiTable.empty() ? 1 : MULTI_SYMBOL_COUNT);
+
+    while (index + batchSymbols <= maxCount && bitStream.getCurrentPosition() + batchBits <= endBit) {
+        bitStream.refill();
+        for (size_t step = 0; step < steps; step++) {
+            if (multiTable.empty()) {
+                output[index++] = decodeOne(bitStream);
+                continue;
+            }
+            const MultiDecodeEntry& entry = multiTable[bitStream.peek(tableBits)];
+            if (entry.count == 0) {
+                output[index++] = decodeOne(bitStream);
+                continue;
+            }
+            std::memcpy(output + index, entry.symbols, MULTI_SYMBOL_COUNT);
+            bitStream.consume(entry.bits);
+            index += entry.count;
+        }
+    }
+
+    while (index < maxCount && bitStream.getCurrentPosition() < endBit) {
+        bitStream.refill();
+        output[index++] = decodeOne(bitStream);
+    }
+
+    return index;
+}
+
+bool HuffmanDecoder::isMultiSymbol() const {
+    return !multiTable.empty();
+}
+
+// 逐位累积码字，与每种码长的首个码字比较：
+// 同一码长的码字连续，落在 [first, first + count) 区间即命中
+
+uint8_t HuffmanDecoder::decodeSerial(BitInputStream& bitStream) const {
+    uint64_t code = 0;  // 当前已读取的码字
+    uint64_t first = 0; // 当前码长的首个码字
+    size_t index = 0;   // 当前码长首个符号在排序表中的位置
+
+    for (uint8_t len = 1; len <= maxLength; len++) {
+        code |= bitStream.readBit() ? 1 : 0;
+        uint16_t count = lengthCount[len];
+        if (code - first < count) {
+            return sortedSymbols[index + (code - first)];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+
+    throw std::runtime_error("无效的哈夫曼编码");
+}
+
+bool HuffmanDecoder::isSingleSymbol() const {
+    return symbolCount == 1;
+}
+
+uint8_t HuffmanDecoder::getFirstSymbol() const {
+    return sortedSymbols[0];
+}
+
+}
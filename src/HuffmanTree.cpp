@@ -1,153 +1,328 @@
 #include "HuffmanTree.hpp"
+#include "Kernels.hpp"
 #include <iostream>
 #include <algorithm>
-#include <queue>
 #include <stdexcept>
-#include <functional>
 
 namespace huffman {
 
-HuffmanTree::HuffmanTree() : root(nullptr) {}
+HuffmanTree::HuffmanTree()
+    : nodes{}, nodeCount(0), root(NULL_NODE), encodeTable{}, codeLengths{}, symbolCount(0)
+    , maxCodeLength(DEFAULT_MAX_CODE_LENGTH), stats{} {}
 
 HuffmanTree::~HuffmanTree() {
     clear();
 }
 
 void HuffmanTree::clear() {
-    root.reset();
-    codeTable.clear();
-    reverseCodeTable.clear();
+    nodeCount = 0;
+    root = NULL_NODE;
+    encodeTable.fill(CodeEntry{0, 0});
+    codeLengths.fill(0);
+    symbolCount = 0;
+    stats = HuffmanStats{};
+}
+
+void HuffmanTree::setMaxCodeLength(uint8_t length) {
+    if (length < MIN_CODE_LENGTH_LIMIT || length > MAX_CODE_LENGTH_LIMIT) {
+        throw std::invalid_argument("最大码长超出范围");
+    }
+    maxCodeLength = length;
 }
 
 bool HuffmanTree::isEmpty() const {
-    return root == nullptr;
+    return symbolCount == 0;
+}
+
+size_t HuffmanTree::getSymbolCount() const {
+    return symbolCount;
+}
+
+uint16_t HuffmanTree::newLeaf(uint8_t data, uint64_t frequency) {
+    if (nodeCount >= MAX_NODE_COUNT) {
+        throw std::runtime_error("哈夫曼树节点数超出上限");
+    }
+    nodes[nodeCount] = HuffmanNode{frequency, NULL_NODE, NULL_NODE, data, true};
+    return nodeCount++;
+}
+
+uint16_t HuffmanTree::newInternal(uint16_t left, uint16_t right) {
+    if (nodeCount >= MAX_NODE_COUNT) {
+        throw std::runtime_error("哈夫曼树节点数超出上限");
+    }
+    uint64_t frequency = (left == NULL_NODE || right == NULL_NODE) ? 0
+        : nodes[left].frequency + nodes[right].frequency;
+    nodes[nodeCount] = HuffmanNode{frequency, left, right, 0, false};
+    return nodeCount++;
 }
 
-void HuffmanTree::buildFromFrequencies(const std::unordered_map<uint8_t, uint32_t>& frequencies) {
-    if (frequencies.empty()) {
+void HuffmanTree::buildFromFrequencies(const Frequencies& frequencies) {
+    // 叶子按（频率, 符号）排序后依次放入节点数组
+    std::array<std::pair<uint64_t, uint8_t>, SYMBOL_COUNT> sorted;
+    size_t leafCount = 0;
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        if (frequencies[symbol] != 0) {
+            sorted[leafCount++] = {frequencies[symbol], static_cast<uint8_t>(symbol)};
+        }
+    }
+    if (leafCount == 0) {
         throw std::invalid_argument("频率表为空");
     }
 
     clear();
+    std::sort(sorted.begin(), sorted.begin() + leafCount);
+    for (size_t i = 0; i < leafCount; i++) {
+        newLeaf(sorted[i].second, sorted[i].first);
+    }
+
+    // 双队列线性构建：
+    // 叶子队列为 [0, leafCount)，新建的内部节点频率单调不减，
+    // 按创建顺序排在叶子之后即构成第二个有序队列，每次从两个队首取最小者
+    uint16_t leafHead = 0;
+    uint16_t internalHead = static_cast<uint16_t>(leafCount);
+    auto takeMin = [&]() -> uint16_t {
+        if (leafHead < leafCount
+            && (internalHead == nodeCount
+                || nodes[leafHead].frequency <= nodes[internalHead].frequency)) {
+            return leafHead++;
+        }
+        return internalHead++;
+    };
+
+    for (size_t i = 1; i < leafCount; i++) {
+        uint16_t left = takeMin();
+        uint16_t right = takeMin();
+        newInternal(left, right);
+    }
+
+    root = static_cast<uint16_t>(nodeCount - 1);
+
+    // 统计各符号的码长（只有一个符号时码长为1）
+    CodeLengths lengths{};
+    collectLengths(root, 0, lengths);
+
+    HuffmanStats buildStats{};
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        buildStats.unlimitedDepth = std::max<size_t>(buildStats.unlimitedDepth, lengths[symbol]);
+        buildStats.unlimitedBits += frequencies[symbol] * lengths[symbol];
+    }
+
+    // 超过码长限制时重新求限长最优码长
+    if (buildStats.unlimitedDepth > maxCodeLength) {
+        lengths = limitCodeLengths(frequencies);
+    }
+
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        buildStats.depth = std::max<size_t>(buildStats.depth, lengths[symbol]);
+        buildStats.encodedBits += frequencies[symbol] * lengths[symbol];
+    }
+
+    // 按码长生成范式编码
+    buildFromLengths(lengths);
+    stats = buildStats;
+}
+
+// package-merge 算法：
+// 第 0 层为按频率排序的叶子；每一层把上一层相邻两项打包，再与叶子按权重归并。
+// 在第 maxCodeLength - 1 层取权重最小的 2n - 2 项，每个符号的码长等于它在各层被选中的次数。
+// 上一层中被选中的恰好是构成本层所选包的前 2p 项，因此可以逐层向下统计
+
+CodeLengths HuffmanTree::limitCodeLengths(const Frequencies& frequencies) const {
+    struct Item {
+        uint64_t weight;
+        int16_t symbol; // 叶子对应的符号，-1 表示包
+    };
+
+    std::vector<Item> leaves;
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        if (frequencies[symbol] != 0) {
+            leaves.push_back({frequencies[symbol], static_cast<int16_t>(symbol)});
+        }
+    }
+    std::sort(leaves.begin(), leaves.end(), [](const Item& a, const Item& b) {
+        return a.weight != b.weight ? a.weight < b.weight : a.symbol < b.symbol;
+    });
+
+    if ((uint64_t(1) << maxCodeLength) < leaves.size()) {
+        throw std::invalid_argument("最大码长过小，无法容纳全部符号");
+    }
+
+    std::vector<std::vector<Item>> levels(maxCodeLength);
+    levels[0] = leaves;
+    for (size_t level = 1; level < maxCodeLength; level++) {
+        const std::vector<Item>& previous = levels[level - 1];
+        std::vector<Item>& current = levels[level];
+        current.reserve(leaves.size() + previous.size() / 2);
+
+        // 叶子与上一层打包结果归并，权重相同时叶子优先
+        size_t leafIndex = 0;
+        size_t packageIndex = 0;
+        size_t packageCount = previous.size() / 2;
+        while (leafIndex < leaves.size() || packageIndex < packageCount) {
+            uint64_t packageWeight = packageIndex < packageCount
+                ? previous[packageIndex * 2].weight + previous[packageIndex * 2 + 1].weight
+                : UINT64_MAX;
+            if (leafIndex < leaves.size() && leaves[leafIndex].weight <= packageWeight) {
+                current.push_back(leaves[leafIndex++]);
+            } else {
+                current.push_back({packageWeight, -1});
+                packageIndex++;
+            }
+        }
+    }
+
+    CodeLengths lengths{};
+    size_t selected = leaves.size() * 2 - 2;
+    for (size_t level = maxCodeLength; level-- > 0 && selected > 0;) {
+        size_t packages = 0;
+        for (size_t i = 0; i < selected; i++) {
+            const Item& item = levels[level][i];
+            if (item.symbol >= 0) {
+                lengths[item.symbol]++;
+            } else {
+                packages++;
+            }
+        }
+        selected = packages * 2;
+    }
+
+    return lengths;
+}
 
-    // 创建优先队列
-    std::priority_queue<std::shared_ptr<HuffmanNode>,
-                        std::vector<std::shared_ptr<HuffmanNode>>,
-                        NodeComparator> minHeap;
+// 范式哈夫曼编码：
+// 码长相同的符号按符号值递增分配连续码字，码长较短的码字排在前面，
+// 因此只需保存每个符号的码长即可还原整张编码表
 
-    // 将所有字符加入优先队列
-    for (const auto& pair : frequencies) {
-        minHeap.push(std::make_shared<HuffmanNode>(pair.first, pair.second, true));
+void HuffmanTree::buildFromLengths(const CodeLengths& lengths) {
+    clear();
+    codeLengths = lengths;
+
+    // 统计每种码长的符号数
+    std::array<uint16_t, MAX_CODE_LENGTH + 1> lengthCount{};
+    for (uint8_t len : codeLengths) {
+        lengthCount[len]++;
+    }
+    lengthCount[0] = 0;
+
+    // 计算每种码长的首个码字
+    std::array<uint64_t, MAX_CODE_LENGTH + 1> nextCode{};
+    uint64_t code = 0;
+    for (size_t len = 1; len <= MAX_CODE_LENGTH; len++) {
+        code = (code + lengthCount[len - 1]) << 1;
+        nextCode[len] = code;
     }
 
-    // 构建哈夫曼树
-    while (minHeap.size() > 1) {
-        auto left = minHeap.top();
-        minHeap.pop();
-        auto right = minHeap.top();
-        minHeap.pop();
+    // 按符号顺序分配码字
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        uint8_t len = codeLengths[symbol];
+        if (len == 0) continue;
 
-        auto parent = std::make_shared<HuffmanNode>(left, right);
-        minHeap.push(parent);
+        encodeTable[symbol] = CodeEntry{static_cast<uint32_t>(nextCode[len]++), len};
+        symbolCount++;
     }
+}
 
-    if (!minHeap.empty()) {
-        root = minHeap.top();
+void HuffmanTree::rebuildTreeFromCodes() {
+    if (symbolCount == 0) {
+        throw std::invalid_argument("码长表为空");
     }
 
-    // 生成编码表
-    std::vector<bool> currentCode;
-    generateCodes(root, currentCode);
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        const CodeEntry& entry = encodeTable[symbol];
+        if (entry.len == 0) continue;
+
+        // 特殊情况：只有一个字符，根节点即为叶子
+        if (symbolCount == 1) {
+            root = newLeaf(static_cast<uint8_t>(symbol), 0);
+            return;
+        }
+
+        if (root == NULL_NODE) {
+            root = newInternal(NULL_NODE, NULL_NODE);
+        }
+        uint16_t node = root;
+        for (uint8_t i = 0; i < entry.len; i++) {
+            bool bit = (entry.code >> (entry.len - 1 - i)) & 1;
+            uint16_t& child = bit ? nodes[node].right : nodes[node].left;
+            if (child == NULL_NODE) {
+                child = i + 1 == entry.len ? newLeaf(static_cast<uint8_t>(symbol), 0)
+                                           : newInternal(NULL_NODE, NULL_NODE);
+            }
+            node = child;
+        }
+    }
 }
 
-void HuffmanTree::buildFromData(const std::vector<uint8_t>& data) {
+void HuffmanTree::collectLengths(uint16_t node, uint8_t depth, CodeLengths& lengths) const {
+    if (nodes[node].isLeaf) {
+        lengths[nodes[node].data] = std::max<uint8_t>(depth, 1);
+        return;
+    }
+    collectLengths(nodes[node].left, depth + 1, lengths);
+    collectLengths(nodes[node].right, depth + 1, lengths);
+}
+
+void HuffmanTree::buildFromData(ByteSpan data) {
     if (data.empty()) {
         throw std::invalid_argument("数据为空");
     }
 
     // 统计频率
-    std::unordered_map<uint8_t, uint32_t> frequencies;
-    for (uint8_t byte : data) {
-        frequencies[byte]++;
-    }
+    Frequencies frequencies{};
+    getKernels().histogram(data.data(), data.size(), frequencies.data());
 
     buildFromFrequencies(frequencies);
 }
 
-void HuffmanTree::generateCodes(const std::shared_ptr<HuffmanNode>& node,
-                                std::vector<bool>& currentCode) {
-    if (!node) return;
+void HuffmanTree::generateCodes(uint16_t index, uint64_t code, uint8_t depth) {
+    if (index == NULL_NODE) return;
+    const HuffmanNode& node = nodes[index];
 
     // 叶子节点，保存编码
-    if (node->isLeaf) {
+    if (node.isLeaf) {
         // 特殊情况：只有一个节点，赋予编码0
-        if (currentCode.empty()) {
-            codeTable[node->data] = std::vector<bool> {false};
-            reverseCodeTable[std::vector<bool>{false}] = node->data;
-        } else {
-            codeTable[node->data] = currentCode;
-            reverseCodeTable[currentCode] = node->data;
+        uint8_t len = std::max<uint8_t>(depth, 1);
+        codeLengths[node.data] = len;
+        symbolCount++;
+        // 旧格式的树可能超过码长上限，这样的码字只能通过遍历树解码
+        if (len <= MAX_CODE_LENGTH) {
+            encodeTable[node.data] = CodeEntry{static_cast<uint32_t>(code), len};
         }
         return;
     }
 
     // 遍历左子树（编码0）
-    currentCode.push_back(false);
-    generateCodes(node->left, currentCode);
-    currentCode.pop_back();
+    generateCodes(node.left, code << 1, depth + 1);
 
     // 遍历右子树（编码1）
-    currentCode.push_back(true);
-    generateCodes(node->right, currentCode);
-    currentCode.pop_back();
+    generateCodes(node.right, (code << 1) | 1, depth + 1);
 }
 
-std::vector<bool> HuffmanTree::getCode(uint8_t byte) const {
-    auto it = codeTable.find(byte);
-    if (it != codeTable.end()) {
-        return it->second;
+const CodeEntry& HuffmanTree::getCode(uint8_t byte) const {
+    if (encodeTable[byte].len == 0) {
+        throw std::runtime_error("未找到字符的编码");
     }
-    throw std::runtime_error("未找到字符的编码");
+    return encodeTable[byte];
 }
 
-const std::unordered_map<uint8_t, std::vector<bool>>& HuffmanTree::getCodeTable() const {
-    return codeTable;
+const EncodeTable& HuffmanTree::getEncodeTable() const {
+    return encodeTable;
 }
 
-std::shared_ptr<HuffmanNode> HuffmanTree::getRoot() const {
+uint16_t HuffmanTree::getRoot() const {
     return root;
 }
 
-// 序列化格式：
-// [1字节: 标志位] [如果是叶子: 1字节数据] [如果不是叶子: 递归序列化左右子树]
-// 标志位: 0x01 = 叶子节点, 0x00 = 内部节点
-
-void HuffmanTree::serializeTree(const std::shared_ptr<HuffmanNode>& node,
-                                std::vector<uint8_t>& output) const {
-    if (!node) return;
-
-    if (node->isLeaf) {
-        output.push_back(0x01);       // 叶子节点标志
-        output.push_back(node->data); // 数据
-    } else {
-        output.push_back(0x00); // 内部节点标志 
-        serializeTree(node->left, output);
-        serializeTree(node->right, output);
-    }
+const HuffmanNode& HuffmanTree::getNode(uint16_t index) const {
+    return nodes[index];
 }
 
-auto HuffmanTree::serialize() const -> std::vector<uint8_t> {
-    if (!root) {
-        throw std::runtime_error("树为空，无法序列化");
-    }
-
-    std::vector<uint8_t> output;
-    serializeTree(root, output);
-    return output;
-}
+// 旧格式的树（前序遍历）：
+// [1字节: 标志位] [如果是叶子: 1字节数据] [如果不是叶子: 递归序列化左右子树]
+// 标志位: 0x01 = 叶子节点, 0x00 = 内部节点
 
-auto HuffmanTree::deserializeTree(const std::vector<uint8_t>& data,
-                                  size_t& index) -> std::shared_ptr<HuffmanNode> {
+auto HuffmanTree::deserializeTree(ByteSpan data,
+                                  size_t& index) -> uint16_t {
     if (index >= data.size()) {
         throw std::runtime_error("反序列化数据不完整");
     }
@@ -159,15 +334,18 @@ auto HuffmanTree::deserializeTree(const std::vector<uint8_t>& data,
             throw std::runtime_error("反序列化数据不完整：缺少叶子节点数据");
         }
         uint8_t byteData = data[index++];
-        return std::make_shared<HuffmanNode>(byteData, 0, true);
-    } else { // 内部节点
-        auto left = deserializeTree(data, index);
-        auto right = deserializeTree(data, index);
-        return std::make_shared<HuffmanNode>(left, right);
+        return newLeaf(byteData, 0);
+    } else { // 内部节点（先分配节点，节点数上限同时限制了递归深度）
+        uint16_t node = newInternal(NULL_NODE, NULL_NODE);
+        uint16_t left = deserializeTree(data, index);
+        uint16_t right = deserializeTree(data, index);
+        nodes[node].left = left;
+        nodes[node].right = right;
+        return node;
     }
 }
 
-void HuffmanTree::deserialize(const std::vector<uint8_t>& data) {
+void HuffmanTree::deserialize(ByteSpan data) {
     if (data.empty()) {
         throw std::invalid_argument("反序列化数据为空");
     }
@@ -177,30 +355,120 @@ void HuffmanTree::deserialize(const std::vector<uint8_t>& data) {
     root = deserializeTree(data, index);
 
     // 重新生成编码表
-    std::vector<bool> currentCode;
-    generateCodes(root, currentCode);
+    generateCodes(root, 0, 0);
 }
 
-size_t HuffmanTree::getDepth() const {
-    if (!root) return 0;
+const CodeLengths& HuffmanTree::getCodeLengths() const {
+    return codeLengths;
+}
 
-    std::function<size_t(std::shared_ptr<HuffmanNode>)> getDepth =
-        [&getDepth](const std::shared_ptr<HuffmanNode>& node) ->size_t {
-        if (!node) return 0;
-        if (node->isLeaf) return 1;
-        return 1 + std::max(getDepth(node->left), getDepth(node->right));
-    };
+// 码长表序列化格式，按大小区分：
+// 列表（1 + 2 × 符号数，奇数）：[1字节: 符号数 - 1] [符号数 × (1字节符号, 1字节码长)]
+// 4 位稠密（128 字节）：第 i 字节高 4 位为符号 2i 的码长，低 4 位为符号 2i+1 的码长，要求码长不超过 15
+// 8 位稠密（256 字节）：第 i 字节为符号 i 的码长
+// 码长 0 表示符号未出现。符号较少时列表最小，符号多时稠密格式最多节省一半
+
+auto HuffmanTree::serializeLengths() const -> std::vector<uint8_t> {
+    if (symbolCount == 0) {
+        throw std::runtime_error("树为空，无法序列化");
+    }
+
+    uint8_t maxLength = *std::max_element(codeLengths.begin(), codeLengths.end());
+    size_t listSize = 1 + size_t(symbolCount) * 2;
+    size_t denseSize = maxLength <= MAX_NIBBLE_CODE_LENGTH ? NIBBLE_TABLE_SIZE : BYTE_TABLE_SIZE;
+
+    std::vector<uint8_t> output;
+    if (denseSize == NIBBLE_TABLE_SIZE && denseSize < listSize) {
+        output.reserve(NIBBLE_TABLE_SIZE);
+        for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol += 2) {
+            output.push_back(static_cast<uint8_t>((codeLengths[symbol] << 4) | codeLengths[symbol + 1]));
+        }
+    } else if (denseSize < listSize) {
+        output.assign(codeLengths.begin(), codeLengths.end());
+    } else {
+        output.reserve(listSize);
+        output.push_back(static_cast<uint8_t>(symbolCount - 1));
+        for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+            if (codeLengths[symbol] != 0) {
+                output.push_back(static_cast<uint8_t>(symbol));
+                output.push_back(codeLengths[symbol]);
+            }
+        }
+    }
+    return output;
+}
+
+auto HuffmanTree::deserializeLengths(ByteSpan data) -> CodeLengths {
+    if (data.empty()) {
+        throw std::invalid_argument("反序列化数据为空");
+    }
+
+    CodeLengths lengths{};
+    if (data.size() == NIBBLE_TABLE_SIZE) {
+        for (size_t i = 0; i < NIBBLE_TABLE_SIZE; i++) {
+            lengths[i * 2] = data[i] >> 4;
+            lengths[i * 2 + 1] = data[i] & 0x0F;
+        }
+    } else if (data.size() == BYTE_TABLE_SIZE) {
+        std::copy(data.begin(), data.end(), lengths.begin());
+    } else {
+        size_t symbolCount = static_cast<size_t>(data[0]) + 1;
+        if (data.size() != 1 + symbolCount * 2) {
+            throw std::runtime_error("码长表数据不完整");
+        }
+        for (size_t i = 0; i < symbolCount; i++) {
+            uint8_t symbol = data[1 + i * 2];
+            uint8_t len = data[2 + i * 2];
+            if (len == 0 || lengths[symbol] != 0) {
+                throw std::runtime_error("码长表数据无效");
+            }
+            lengths[symbol] = len;
+        }
+    }
+
+    size_t symbolCount = 0;
+    std::array<uint16_t, MAX_CODE_LENGTH + 1> lengthCount{};
+    for (uint8_t len : lengths) {
+        if (len > MAX_CODE_LENGTH) {
+            throw std::runtime_error("码长表数据无效");
+        }
+        lengthCount[len]++;
+        symbolCount += len != 0;
+    }
+    lengthCount[0] = 0;
+    if (symbolCount == 0) {
+        throw std::runtime_error("码长表数据无效");
+    }
+
+    // 检查 Kraft 不等式，码字不能超额分配
+    int64_t left = 1;
+    for (size_t len = 1; len <= MAX_CODE_LENGTH; len++) {
+        left = std::min<int64_t>(left * 2, SYMBOL_COUNT * 2) - lengthCount[len];
+        if (left < 0) {
+            throw std::runtime_error("码长表数据无效：前缀码超额分配");
+        }
+    }
+
+    return lengths;
+}
+
+size_t HuffmanTree::getDepth() const {
+    return *std::max_element(codeLengths.begin(), codeLengths.end());
+}
 
-    return getDepth(root);
+const HuffmanStats& HuffmanTree::getStats() const {
+    return stats;
 }
 
 void HuffmanTree::printCodeTable() const {
     std::cout << "哈夫曼编码表：" << std::endl;
-    for (const auto& pair : codeTable) {
-        std::cout << "字符 '" << (pair.first >= 32 && pair.first < 127 ? static_cast<char>(pair.first) : '?') 
-                  << "' (" << static_cast<int>(pair.first) << "): ";
-        for (bool bit : pair.second) {
-            std::cout << (bit ? '1' : '0');
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        const CodeEntry& entry = encodeTable[symbol];
+        if (entry.len == 0) continue;
+        std::cout << "字符 '" << (symbol >= 32 && symbol < 127 ? static_cast<char>(symbol) : '?') 
+                  << "' (" << symbol << "): ";
+        for (uint8_t i = 0; i < entry.len; i++) {
+            std::cout << (((entry.code >> (entry.len - 1 - i)) & 1) ? '1' : '0');
         }
         std::cout << std::endl;
     }
@@ -0,0 +1,113 @@
+#include "Kernels.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace huffman {
+
+namespace kernels {
+namespace scalar { extern const KernelTable kernelTable; }
+#ifdef HUFFMAN_X86_KERNELS
+namespace bmi2 { extern const KernelTable kernelTable; }
+namespace avx2 { extern const KernelTable kernelTable; }
+namespace avx512 { extern const KernelTable kernelTable; }
+#endif
+}
+
+namespace {
+
+// 编译进来的内核，按指令集从低到高排列
+const KernelTable* compiledKernel(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar:
+        return &kernels::scalar::kernelTable;
+#ifdef HUFFMAN_X86_KERNELS
+    case Isa::Bmi2:
+        return &kernels::bmi2::kernelTable;
+    case Isa::Avx2:
+        return &kernels::avx2::kernelTable;
+    case Isa::Avx512:
+        return &kernels::avx512::kernelTable;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+// 首次使用时选择内核
+const KernelTable* selectKernels() {
+    const char* name = std::getenv("HUFFMAN_ISA");
+    Isa isa = name != nullptr && *name != '\0' ? parseIsa(name) : detectIsa();
+    if (isa > detectIsa() || compiledKernel(isa) == nullptr) {
+        throw std::runtime_error(std::string("当前 CPU 或构建不支持指令集: ") + isaName(isa));
+    }
+    return compiledKernel(isa);
+}
+
+std::atomic<const KernelTable*> activeKernels{nullptr};
+
+}
+
+Isa detectIsa() {
+#ifdef HUFFMAN_X86_KERNELS
+    // __builtin_cpu_supports 同时检查了操作系统是否保存对应的寄存器状态
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2")) {
+        return Isa::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2")) {
+        return Isa::Avx2;
+    }
+    if (__builtin_cpu_supports("bmi2")) {
+        return Isa::Bmi2;
+    }
+#endif
+    return Isa::Scalar;
+}
+
+const KernelTable& getKernels() {
+    const KernelTable* kernels = activeKernels.load(std::memory_order_acquire);
+    if (kernels == nullptr) {
+        static const KernelTable* selected = selectKernels();
+        const KernelTable* expected = nullptr;
+        activeKernels.compare_exchange_strong(expected, selected, std::memory_order_acq_rel);
+        kernels = activeKernels.load(std::memory_order_acquire);
+    }
+    return *kernels;
+}
+
+Isa getIsa() {
+    return getKernels().isa;
+}
+
+void setIsa(Isa isa) {
+    if (isa > detectIsa() || compiledKernel(isa) == nullptr) {
+        throw std::runtime_error(std::string("当前 CPU 或构建不支持指令集: ") + isaName(isa));
+    }
+    activeKernels.store(compiledKernel(isa), std::memory_order_release);
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar:
+        return "scalar";
+    case Isa::Bmi2:
+        return "bmi2";
+    case Isa::Avx2:
+        return "avx2";
+    case Isa::Avx512:
+        return "avx512";
+    }
+    return "unknown";
+}
+
+Isa parseIsa(const std::string& name) {
+    for (Isa isa : {Isa::Scalar, Isa::Bmi2, Isa::Avx2, Isa::Avx512}) {
+        if (name == isaName(isa)) {
+            return isa;
+        }
+    }
+    throw std::invalid_argument("未知的指令集: " + name);
+}
+
+}
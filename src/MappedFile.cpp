@@ -0,0 +1,71 @@
+#include "MappedFile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace huffman {
+
+MappedFile::MappedFile(const std::string& filename) : address(nullptr), length(0) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("无法打开文件：" + filename + "（" + std::strerror(errno) + "）");
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        ::close(fd);
+        throw std::runtime_error("不是普通文件：" + filename);
+    }
+    length = static_cast<size_t>(status.st_size);
+
+    // 长度为 0 时不能映射，保持空视图
+    if (length > 0) {
+        void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("映射文件失败：" + filename + "（" + std::strerror(error) + "）");
+        }
+        address = static_cast<const uint8_t*>(mapping);
+    }
+
+    // 映射建立后不再需要文件描述符
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (address != nullptr) {
+        ::munmap(const_cast<uint8_t*>(address), length);
+    }
+}
+
+ByteSpan MappedFile::data() const {
+    return ByteSpan(address, length);
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
+
+void MappedFile::adviseSequential() const {
+    if (address == nullptr) {
+        return;
+    }
+
+    // 只是提示，失败时不影响读取
+    void* mapping = const_cast<uint8_t*>(address);
+    ::madvise(mapping, length, MADV_SEQUENTIAL);
+    ::madvise(mapping, length, MADV_WILLNEED);
+}
+
+void MappedFile::adviseRandom() const {
+    if (address != nullptr) {
+        ::madvise(const_cast<uint8_t*>(address), length, MADV_RANDOM);
+    }
+}
+
+}
@@ -24,17 +24,6 @@ std::vector<uint8_t> Packer::readFile(const std::string& filename) {
     return buffer;
 }
 
-void Packer::writeFile(const std::string& fileName, const std::vector<uint8_t>& data) {
-    std::ofstream file(fileName, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("创建文件失败: " + fileName);
-    }
-
-    if (!file.write(reinterpret_cast<const char*>(data.data()), data.size())) {
-        throw std::runtime_error("写入文件失败: " + fileName);
-    }
-}
- 
 std::string Packer::combinePath(const std::string& dir, const std::string& file) {
     return (fs::path(dir) / file).string();
 }
@@ -87,39 +76,8 @@ void Packer::serializeEntry(const DirectoryEntry& entry, BitOutputStream& bitStr
     }
 }
 
-DirectoryEntry Packer::deserializeEntry(BitInputStream& bitStream) {
-    DirectoryEntry entry;
-    
-    // 读取类型
-    entry.type = static_cast<EntryType>(bitStream.readByte());
-    // 如果是结束标记，直接返回
-    if (entry.type == EntryType::END) {
-        return entry;
-    }
-    
-    // 读取相对路径长度
-    uint16_t pathLength = (static_cast<uint16_t>(bitStream.readByte()) << 8) |
-                          bitStream.readByte();
-
-    // 读取相对路径
-    entry.relativePath.clear();
-    for (uint16_t i = 0; i < pathLength; i++) {
-        entry.relativePath += static_cast<char>(bitStream.readByte());
-    }
-
-    // 如果是文件，读取文件信息
-    if (entry.type == EntryType::FILE) {
-        // 读取文件原始大小
-        entry.size = 0;
-        for (int i = 0; i < 8; i++) {
-            entry.size = (entry.size << 8) | bitStream.readByte();
-        }
-
-        // 读取数据
-        entry.data = bitStream.readBytes(entry.size);
-    }
-
-    return entry;
+void Packer::setVerbose(bool verbose) {
+    this->verbose = verbose;
 }
 
 std::vector<uint8_t> Packer::pack(const std::vector<std::string>& sources) {
@@ -153,34 +111,25 @@ std::vector<uint8_t> Packer::pack(const std::vector<std::string>& sources) {
         serializeEntry(entry, bitStream);
     }
 
-    return bitStream.getBuffer();
+    return bitStream.takeBuffer();
 }
 
-void Packer::unpack(const std::vector<uint8_t>& packedData, const std::string& outputDir) {
-    // 检查输出目录是否存在，不存在则创建
-    if (!fs::exists(outputDir)) {
-        fs::create_directories(outputDir);
+bool Packer::parseFileHeader(ByteSpan data, uint64_t& contentOffset, uint64_t& fileSize) {
+    if (data.size() < 3 || data[0] != static_cast<uint8_t>(EntryType::FILE)) {
+        return false;
     }
 
-    // 反序列化目录项
-    BitInputStream bitStream(packedData);
-    while (true) {
-        DirectoryEntry entry = deserializeEntry(bitStream);
-        if (entry.type == EntryType::END) {
-            break;
-        }
-
-        // 构建完整路径
-        std::string fullPath = combinePath(outputDir, entry.relativePath);
+    size_t pathLength = (size_t(data[1]) << 8) | data[2];
+    if (data.size() < 3 + pathLength + 8) {
+        return false;
+    }
 
-        if (entry.type == EntryType::DIR) {
-            // 创建目录（如果是目录）
-            fs::create_directories(fullPath);
-        } else if (entry.type == EntryType::FILE) {
-            // 写入文件
-            writeFile(fullPath, entry.data);
-        }
+    fileSize = 0;
+    for (size_t i = 0; i < 8; i++) {
+        fileSize = (fileSize << 8) | data[3 + pathLength + i];
     }
+    contentOffset = 3 + pathLength + 8;
+    return true;
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "StreamUnpacker.hpp"
+#include "Packer.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace huffman {
+
+StreamUnpacker::StreamUnpacker(const std::string& outputDir)
+    : outputDir(outputDir), remaining(0), finished(false) {
+    // 检查输出目录是否存在，不存在则创建
+    if (!fs::exists(outputDir)) {
+        fs::create_directories(outputDir);
+    }
+}
+
+// 目录项头部：[1字节类型][2字节路径长度][路径]，文件再加 [8字节文件大小]，均为大端序
+
+void StreamUnpacker::parseEntry() {
+    EntryType type = static_cast<EntryType>(pending[0]);
+    if (type == EntryType::END) {
+        finished = true;
+        pending.clear();
+        return;
+    }
+    if (type != EntryType::FILE && type != EntryType::DIR) {
+        throw std::runtime_error("无效的目录项类型");
+    }
+    if (pending.size() < 3) {
+        return;
+    }
+
+    size_t pathLength = (size_t(pending[1]) << 8) | pending[2];
+    size_t headerSize = 3 + pathLength + (type == EntryType::FILE ? 8 : 0);
+    if (pending.size() < headerSize) {
+        return;
+    }
+
+    std::string relativePath(pending.begin() + 3, pending.begin() + 3 + pathLength);
+    std::string fullPath = (fs::path(outputDir) / relativePath).string();
+
+    if (type == EntryType::DIR) {
+        fs::create_directories(fullPath);
+    } else {
+        remaining = 0;
+        for (size_t i = 0; i < 8; i++) {
+            remaining = (remaining << 8) | pending[3 + pathLength + i];
+        }
+        file.open(fullPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("创建文件失败: " + fullPath);
+        }
+        filePath = fullPath;
+        if (remaining == 0) {
+            closeFile();
+        }
+    }
+    pending.clear();
+}
+
+void StreamUnpacker::closeFile() {
+    file.close();
+    if (!file) {
+        throw std::runtime_error("写入文件失败: " + filePath);
+    }
+}
+
+void StreamUnpacker::write(ByteSpan data) {
+    size_t offset = 0;
+    // 结束标记之后还跟着一个不使用的路径长度字段，与其后的数据一起忽略
+    while (offset < data.size() && !finished) {
+
+        // 文件内容直接写入
+        if (remaining > 0) {
+            size_t count = static_cast<size_t>(std::min<uint64_t>(remaining, data.size() - offset));
+            if (!file.write(reinterpret_cast<const char*>(data.data() + offset), count)) {
+                throw std::runtime_error("写入文件失败: " + filePath);
+            }
+            remaining -= count;
+            offset += count;
+            if (remaining == 0) {
+                closeFile();
+            }
+            continue;
+        }
+
+        // 目录项头部很短，逐字节累积到完整后再解析
+        pending.push_back(data[offset++]);
+        parseEntry();
+    }
+}
+
+void StreamUnpacker::finish() {
+    if (!finished) {
+        throw std::runtime_error("打包数据不完整");
+    }
+}
+
+}
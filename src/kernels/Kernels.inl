@@ -0,0 +1,310 @@
+// 各指令集版本共用的内核实现
+// 由 Kernels<指令集>.cpp 定义 HUFFMAN_KERNEL_NAMESPACE 和 HUFFMAN_KERNEL_ISA 后包含，
+// 以各自的编译选项生成一份代码。
+// 这里只调用本文件中具有内部链接的函数：头文件中的内联函数和模板若在这里实例化，
+// 链接器可能只保留以较高指令集编译的那一份，在不支持的 CPU 上执行时出错
+
+#include "Kernels.hpp"
+#include "BitStream.hpp"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace huffman {
+namespace kernels {
+namespace HUFFMAN_KERNEL_NAMESPACE {
+
+namespace {
+
+inline uint64_t loadWord(const uint8_t* src) {
+    uint64_t value;
+    __builtin_memcpy(&value, src, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+inline void storeWord(uint8_t* dest, uint64_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    __builtin_memcpy(dest, &value, sizeof(value));
+}
+
+// 与 BitInputStream 相同的左对齐位容器
+struct BitReader {
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+    uint64_t container;
+};
+
+// 补充后容器中至少有 MIN_REFILL_BITS 位，超出数据末尾的部分为 0
+inline void refill(BitReader& reader) {
+    size_t byteIndex = reader.position >> 3;
+    unsigned offset = reader.position & 7;
+    uint64_t word = 0;
+    if (byteIndex + 8 <= reader.size) {
+        word = loadWord(reader.data + byteIndex);
+    } else {
+        for (size_t i = 0; i < 8; i++) {
+            size_t index = byteIndex + i;
+            word = (word << 8) | (index < reader.size ? reader.data[index] : 0);
+        }
+    }
+    reader.container = word << offset;
+}
+
+inline void consume(BitReader& reader, unsigned count) {
+    reader.container <<= count;
+    reader.position += count;
+}
+
+// 查表解码一个符号，要求容器中至少有 maxLength 位
+inline uint8_t decodeOne(const DecodeTables& tables, BitReader& reader, bool& invalid) {
+    DecodeEntry entry = tables.primary[reader.container >> (64 - tables.tableBits)];
+    if (entry.length == 0 && entry.subBits != 0) {
+        uint64_t bits = reader.container >> (64 - tables.tableBits - entry.subBits);
+        entry = tables.secondary[entry.value + (bits & ((uint64_t(1) << entry.subBits) - 1))];
+    }
+    invalid |= entry.length == 0;
+    consume(reader, entry.length);
+    return static_cast<uint8_t>(entry.value);
+}
+
+// 多符号查表，一次最多解出 MULTI_SYMBOL_COUNT 个符号，要求 output 之后至少可写 4 个字节
+inline void decodeMulti(const DecodeTables& tables, BitReader& reader, uint8_t* output,
+    size_t& index, bool& invalid) {
+    const MultiDecodeEntry& entry = tables.multi[reader.container >> (64 - tables.tableBits)];
+    if (entry.count == 0) {
+        output[index++] = decodeOne(tables, reader, invalid);
+        return;
+    }
+    __builtin_memcpy(output + index, entry.symbols, MULTI_SYMBOL_COUNT);
+    consume(reader, entry.bits);
+    index += entry.count;
+}
+
+// 连续的相同字节会反复读写同一个计数，每次自增都要等上一次的写入完成。
+// 相邻字节轮流计入 HISTOGRAM_TABLES 张子表，同一计数的读写间隔拉开，最后再合并
+constexpr size_t HISTOGRAM_TABLES = 4;
+
+void histogram(const uint8_t* data, size_t size, uint64_t* counts) {
+    uint64_t tables[HISTOGRAM_TABLES][SYMBOL_COUNT] = {};
+    size_t i = 0;
+
+    // 每次读取 2 个 64 位整字，逐字节分发到各子表
+    for (; i + 16 <= size; i += 16) {
+        uint64_t word0;
+        uint64_t word1;
+        __builtin_memcpy(&word0, data + i, sizeof(word0));
+        __builtin_memcpy(&word1, data + i + 8, sizeof(word1));
+        for (unsigned shift = 0; shift < 64; shift += 16) {
+            tables[0][(word0 >> shift) & 0xFF]++;
+            tables[1][(word0 >> (shift + 8)) & 0xFF]++;
+            tables[2][(word1 >> shift) & 0xFF]++;
+            tables[3][(word1 >> (shift + 8)) & 0xFF]++;
+        }
+    }
+    for (; i < size; i++) {
+        tables[0][data[i]]++;
+    }
+
+    for (size_t symbol = 0; symbol < SYMBOL_COUNT; symbol++) {
+        counts[symbol] += tables[0][symbol] + tables[1][symbol] + tables[2][symbol] + tables[3][symbol];
+    }
+}
+
+// 把 bits 的低 length 位追加到累加器，满 64 位时整字写出，要求 length < 64
+inline void putBits(uint64_t& buffer, unsigned& count, uint8_t* out, size_t& written,
+    uint64_t bits, unsigned length) {
+    if (count + length < 64) {
+        buffer = (buffer << length) | bits;
+        count += length;
+        return;
+    }
+
+    // 先用 bits 的高位补满 64 位整字写出，剩余低位留在累加器中
+    unsigned rest = count + length - 64;
+    storeWord(out + written, (buffer << (64 - count)) | (bits >> rest));
+    written += 8;
+    buffer = bits;
+    count = rest;
+}
+
+#ifdef __AVX2__
+
+// 向量编码要求 4 个码字拼接后不超过 63 位
+constexpr unsigned VECTOR_ENCODE_MAX_LENGTH = 15;
+
+// 每次编码 8 个符号：聚集读取码字和码长，相邻码字两两拼接两轮，
+// 每个 128 位通道得到 4 个符号拼成的码字，再逐个追加到累加器
+inline size_t encodeAvx2(const CodeEntry* table, const uint8_t* data, size_t size,
+    uint8_t* out, size_t& written, uint64_t& buffer, unsigned& count) {
+    const int* codeBase = reinterpret_cast<const int*>(table);
+    const int* lengthBase = reinterpret_cast<const int*>(reinterpret_cast<const uint8_t*>(table)
+        + offsetof(CodeEntry, len));
+    const __m256i lowMask = _mm256_set1_epi64x(0xFFFFFFFF);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + i)));
+        __m256i codes = _mm256_i32gather_epi32(codeBase, index, sizeof(CodeEntry));
+        __m256i lengths = _mm256_and_si256(
+            _mm256_i32gather_epi32(lengthBase, index, sizeof(CodeEntry)), byteMask);
+
+        // 第一轮：64 位通道内低 32 位的符号在前
+        __m256i laterLengths = _mm256_srli_epi64(lengths, 32);
+        __m256i pairs = _mm256_or_si256(
+            _mm256_sllv_epi64(_mm256_and_si256(codes, lowMask), laterLengths),
+            _mm256_srli_epi64(codes, 32));
+        __m256i pairLengths = _mm256_add_epi64(_mm256_and_si256(lengths, lowMask), laterLengths);
+
+        // 第二轮：128 位通道内低 64 位的一对在前
+        __m256i laterPairLengths = _mm256_srli_si256(pairLengths, 8);
+        __m256i quads = _mm256_or_si256(_mm256_sllv_epi64(pairs, laterPairLengths),
+            _mm256_srli_si256(pairs, 8));
+        __m256i quadLengths = _mm256_add_epi64(pairLengths, laterPairLengths);
+
+        alignas(32) uint64_t quadWords[4];
+        alignas(32) uint64_t quadBits[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(quadWords), quads);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(quadBits), quadLengths);
+        putBits(buffer, count, out, written, quadWords[0], static_cast<unsigned>(quadBits[0]));
+        putBits(buffer, count, out, written, quadWords[2], static_cast<unsigned>(quadBits[2]));
+    }
+
+    return i;
+}
+
+#endif
+
+size_t encode(const CodeEntry* table, unsigned maxLength, const uint8_t* data, size_t size,
+    uint8_t* out, uint64_t& bitBuffer, unsigned& bitCount) {
+    uint64_t buffer = bitBuffer;
+    unsigned count = bitCount;
+    size_t written = 0;
+    size_t i = 0;
+
+#ifdef __AVX2__
+    if (maxLength <= VECTOR_ENCODE_MAX_LENGTH) {
+        i = encodeAvx2(table, data, size, out, written, buffer, count);
+    }
+#else
+    (void)maxLength;
+#endif
+
+    for (; i < size; i++) {
+        const CodeEntry& entry = table[data[i]];
+        putBits(buffer, count, out, written, entry.code, entry.len);
+    }
+
+    bitBuffer = buffer;
+    bitCount = count;
+    return written;
+}
+
+// 每次补充位容器后至少有 MIN_REFILL_BITS 位可用，而每次查表最多消耗 maxLength 位，
+// 因此补充一次可以连续查表 MIN_REFILL_BITS / maxLength 次，循环内不再做越界检查
+
+size_t decode(const DecodeTables& tables, const uint8_t* data, size_t size, size_t position,
+    uint8_t* output, size_t count) {
+    BitReader reader = {data, size, position, 0};
+    bool invalid = false;
+    size_t index = 0;
+    size_t steps = MIN_REFILL_BITS / tables.maxLength;
+
+    if (tables.multi != nullptr) {
+        // 每次写入完整的 4 个字节，由 index 决定实际保留多少
+        while (index + MULTI_SYMBOL_COUNT * steps <= count) {
+            refill(reader);
+            for (size_t step = 0; step < steps; step++) {
+                decodeMulti(tables, reader, output, index, invalid);
+            }
+        }
+    }
+
+    while (index + steps <= count) {
+        refill(reader);
+        for (size_t step = 0; step < steps; step++) {
+            output[index++] = decodeOne(tables, reader, invalid);
+        }
+    }
+
+    while (index < count) {
+        refill(reader);
+        output[index++] = decodeOne(tables, reader, invalid);
+    }
+
+    return invalid ? DECODE_INVALID : reader.position;
+}
+
+bool decode4(const DecodeTables& tables, const uint8_t* const* data, const size_t* sizes,
+    size_t* positions, uint8_t* const* outputs, size_t* indices, size_t count) {
+    BitReader reader0 = {data[0], sizes[0], positions[0], 0};
+    BitReader reader1 = {data[1], sizes[1], positions[1], 0};
+    BitReader reader2 = {data[2], sizes[2], positions[2], 0};
+    BitReader reader3 = {data[3], sizes[3], positions[3], 0};
+    size_t index0 = indices[0], index1 = indices[1], index2 = indices[2], index3 = indices[3];
+    bool invalid = false;
+    size_t steps = MIN_REFILL_BITS / tables.maxLength;
+
+    if (tables.multi != nullptr) {
+        // 多符号查表每次解出的符号数不同，各条链分别记录位置
+        size_t limit = MULTI_SYMBOL_COUNT * steps;
+        while (index0 + limit <= count && index1 + limit <= count
+            && index2 + limit <= count && index3 + limit <= count) {
+            refill(reader0);
+            refill(reader1);
+            refill(reader2);
+            refill(reader3);
+            for (size_t step = 0; step < steps; step++) {
+                decodeMulti(tables, reader0, outputs[0], index0, invalid);
+                decodeMulti(tables, reader1, outputs[1], index1, invalid);
+                decodeMulti(tables, reader2, outputs[2], index2, invalid);
+                decodeMulti(tables, reader3, outputs[3], index3, invalid);
+            }
+        }
+    } else {
+        while (index0 + steps <= count && index1 + steps <= count
+            && index2 + steps <= count && index3 + steps <= count) {
+            refill(reader0);
+            refill(reader1);
+            refill(reader2);
+            refill(reader3);
+            for (size_t step = 0; step < steps; step++) {
+                outputs[0][index0++] = decodeOne(tables, reader0, invalid);
+                outputs[1][index1++] = decodeOne(tables, reader1, invalid);
+                outputs[2][index2++] = decodeOne(tables, reader2, invalid);
+                outputs[3][index3++] = decodeOne(tables, reader3, invalid);
+            }
+        }
+    }
+
+    positions[0] = reader0.position;
+    positions[1] = reader1.position;
+    positions[2] = reader2.position;
+    positions[3] = reader3.position;
+    indices[0] = index0;
+    indices[1] = index1;
+    indices[2] = index2;
+    indices[3] = index3;
+    return !invalid;
+}
+
+}
+
+extern const KernelTable kernelTable = {
+    HUFFMAN_KERNEL_ISA,
+    histogram,
+    encode,
+    decode,
+    decode4,
+};
+
+}
+}
+}
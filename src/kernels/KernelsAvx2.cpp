@@ -0,0 +1,4 @@
+// 内核的 avx2 版本，编译选项见 CMakeLists.txt
+#define HUFFMAN_KERNEL_NAMESPACE avx2
+#define HUFFMAN_KERNEL_ISA Isa::Avx2
+#include "Kernels.inl"
@@ -0,0 +1,4 @@
+// 内核的 avx512 版本，编译选项见 CMakeLists.txt
+#define HUFFMAN_KERNEL_NAMESPACE avx512
+#define HUFFMAN_KERNEL_ISA Isa::Avx512
+#include "Kernels.inl"
@@ -0,0 +1,4 @@
+// 内核的 bmi2 版本，编译选项见 CMakeLists.txt
+#define HUFFMAN_KERNEL_NAMESPACE bmi2
+#define HUFFMAN_KERNEL_ISA Isa::Bmi2
+#include "Kernels.inl"
@@ -0,0 +1,4 @@
+// 内核的 scalar 版本，编译选项见 CMakeLists.txt
+#define HUFFMAN_KERNEL_NAMESPACE scalar
+#define HUFFMAN_KERNEL_ISA Isa::Scalar
+#include "Kernels.inl"
@@ -1,5 +1,7 @@
 #include "CLI11.hpp"
 #include "HuffmanArchiver.hpp"
+#include "Kernels.hpp"
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -14,12 +16,12 @@ int main(int argc, char* argv[]) {
         auto compressCmd = app.add_subcommand("compress", "Compress files or folders");
         
         std::vector<std::string> sources;
-        compressCmd->add_option("sources", sources)->expected(1, -1);
+        compressCmd->add_option("sources", sources, "Files or folders, or - to stream stdin")->expected(1, -1);
 
         // 解压子命令
         auto extraCmd = app.add_subcommand("extra", "Extea from archive");
         std::string source;
-        extraCmd->add_option("source", source)->required();
+        extraCmd->add_option("source", source, "Archive, or - to read stdin")->required();
         
         // 输出参数
         std::string outputPath;
@@ -29,19 +31,84 @@ int main(int argc, char* argv[]) {
         compressCmd->add_flag("-v,--verbose", verbose);
         extraCmd->add_flag("-v,--verbose", verbose);
 
+        unsigned maxCodeLength = DEFAULT_MAX_CODE_LENGTH;
+        compressCmd->add_option("--max-code-length", maxCodeLength, "Maximum Huffman code length")
+            ->check(CLI::Range(MIN_CODE_LENGTH_LIMIT, MAX_CODE_LENGTH_LIMIT));
+
+        size_t blockSize = DEFAULT_BLOCK_SIZE;
+        compressCmd->add_option("--block-size", blockSize, "Block size of the v2 format (64K..8M)")
+            ->transform(CLI::AsSizeValue(false))
+            ->check(CLI::Range(MIN_BLOCK_SIZE, MAX_BLOCK_SIZE));
+
+        size_t streamCount = 4;
+        compressCmd->add_option("--streams", streamCount, "Interleaved bitstreams per block")
+            ->check(CLI::IsMember({1, 4}));
+
+        size_t threadCount = 1;
+        compressCmd->add_option("-j,--jobs", threadCount, "Number of threads (0 = all cores)");
+        extraCmd->add_option("-j,--jobs", threadCount, "Number of threads (0 = all cores)");
+
+        std::string isa;
+        compressCmd->add_option("--isa", isa, "Force the kernel instruction set")
+            ->check(CLI::IsMember({"scalar", "bmi2", "avx2", "avx512"}));
+        extraCmd->add_option("--isa", isa, "Force the kernel instruction set")
+            ->check(CLI::IsMember({"scalar", "bmi2", "avx2", "avx512"}));
+
+        bool legacy = false;
+        compressCmd->add_flag("--legacy", legacy, "Write the single-stream v1 format");
+
+        bool blockIndex = false;
+        compressCmd->add_flag("--index", blockIndex, "Append a block index for range extraction");
+
+        std::vector<uint64_t> range;
+        extraCmd->add_option("--range", range, "Extract only LENGTH bytes starting at OFFSET")
+            ->expected(2)
+            ->type_name("OFFSET LENGTH");
+
+        bool treeWalk = false;
+        extraCmd->add_flag("--tree-walk", treeWalk, "Decode by walking the Huffman tree bit by bit");
+
         // 解析命令行参数
         CLI11_PARSE(app, argc, argv);
 
+        // 必须在启动工作线程之前选定内核
+        if (!isa.empty()) {
+            setIsa(parseIsa(isa));
+        }
+
+        // 流式压缩或解压到标准输出时，标准输出可能是数据本身，详细信息写到标准错误
+        bool streamInput = compressCmd->parsed()
+            && std::find(sources.begin(), sources.end(), "-") != sources.end();
+        bool rangeOutput = extraCmd->parsed() && !range.empty();
+        bool streamOutput = extraCmd->parsed()
+            && (outputPath == "-" || (outputPath.empty() && (source == "-" || rangeOutput)));
+        if (streamInput && sources.size() > 1) {
+            std::cerr << "ERORR: - 不能与其他输入一起使用" << std::endl;
+            return 1;
+        }
+
         HuffmanArchiver archiver;
 
         if (verbose) {
-            archiver
+            archiver.setVerbose(true);
+            (streamInput || streamOutput ? std::cerr : std::cout) << "指令集: " << isaName(getIsa()) << std::endl;
         }
+        archiver.setMaxCodeLength(static_cast<uint8_t>(maxCodeLength));
+        archiver.setBlockSize(blockSize);
+        archiver.setStreamCount(streamCount);
+        archiver.setThreadCount(threadCount);
+        archiver.setLegacyFormat(legacy);
+        archiver.setBlockIndex(blockIndex);
+        archiver.setTreeWalkDecoding(treeWalk);
 
         bool isSuccess = true;
         
-        if (compressCmd->parsed()) {
+        if (streamInput) {
+            isSuccess = archiver.compressStream(outputPath);
+        } else if (compressCmd->parsed()) {
             isSuccess = archiver.compress(sources, outputPath);
+        } else if (rangeOutput) {
+            isSuccess = archiver.decompressRange(source, range[0], range[1], outputPath);
         } else if (extraCmd->parsed()) {
             isSuccess = archiver.decompress(source, outputPath);
         }
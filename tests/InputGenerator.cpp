@@ -0,0 +1,105 @@
+// 生成往返测试用的固定输入：同样的参数总是生成同样的数据
+// 用法: input_generator <random|skewed|text> <大小> <输出文件>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// xorshift64*，与标准库实现无关，各平台输出一致
+class Random {
+private:
+    uint64_t state;
+
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    // [0, 1) 均匀分布
+    double uniform() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+// 均匀随机字节，压缩时各块按原样存储
+std::vector<uint8_t> generateRandom(size_t size, Random& random) {
+    std::vector<uint8_t> data(size);
+    for (uint8_t& byte : data) {
+        byte = static_cast<uint8_t>(random.next() >> 56);
+    }
+    return data;
+}
+
+// 几何分布的字节：符号多且尾部很长，码长会超过 15，不限长时可达 20 以上
+std::vector<uint8_t> generateSkewed(size_t size, Random& random) {
+    std::vector<uint8_t> data(size);
+    for (uint8_t& byte : data) {
+        double value = -std::log(1.0 - random.uniform()) / 0.08;
+        byte = static_cast<uint8_t>(value < 255.0 ? value : 255.0);
+    }
+    return data;
+}
+
+// 类似日志的文本行
+std::vector<uint8_t> generateText(size_t size, Random& random) {
+    static const char* const words[] = {
+        "INFO", "WARN", "DEBUG", "request", "response", "user", "session", "cache",
+        "miss", "hit", "latency", "ms", "status", "ok", "error", "retry", "queue", "worker",
+    };
+    constexpr size_t WORD_COUNT = sizeof(words) / sizeof(words[0]);
+
+    std::string text;
+    text.reserve(size + 128);
+    while (text.size() < size) {
+        text += std::to_string(random.next() % 100000);
+        for (size_t i = 0, count = 3 + random.next() % 6; i < count; i++) {
+            text += ' ';
+            text += words[random.next() % WORD_COUNT];
+        }
+        text += " id=" + std::to_string(random.next() % 1000) + '\n';
+    }
+    return std::vector<uint8_t>(text.begin(), text.begin() + size);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 4) {
+        std::cerr << "用法: " << argv[0] << " <random|skewed|text> <大小> <输出文件>" << std::endl;
+        return 1;
+    }
+
+    std::string kind = argv[1];
+    size_t size = std::strtoull(argv[2], nullptr, 10);
+    Random random(0x9E3779B97F4A7C15ULL);
+
+    std::vector<uint8_t> data;
+    if (kind == "random") {
+        data = generateRandom(size, random);
+    } else if (kind == "skewed") {
+        data = generateSkewed(size, random);
+    } else if (kind == "text") {
+        data = generateText(size, random);
+    } else {
+        std::cerr << "未知的输入类型: " << kind << std::endl;
+        return 1;
+    }
+
+    std::ofstream file(argv[3], std::ios::binary);
+    if (!file.write(reinterpret_cast<const char*>(data.data()), data.size())) {
+        std::cerr << "写入文件失败: " << argv[3] << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+#!/bin/bash
+# 往返测试：同一输入在各指令集、线程数和位流数下压缩的结果必须逐字节相同，解压后与输入相同
+# 用法: roundtrip.sh <huffman_compressor> <input_generator>
+# 检查内存错误和未定义行为时用 cmake -DHUFFMAN_SANITIZE=ON 构建后运行
+
+set -euo pipefail
+
+BIN=$1
+GENERATOR=$2
+JOBS=4
+INPUT_SIZE=$((1024 * 1024))
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# 只测试当前 CPU 支持的指令集
+ISAS=()
+printf 'x' > "$WORK/probe"
+for isa in scalar bmi2 avx2 avx512; do
+    if "$BIN" -o "$WORK/probe-$isa.huff" compress --isa "$isa" "$WORK/probe" > /dev/null 2>&1; then
+        ISAS+=("$isa")
+    else
+        echo "跳过不支持的指令集: $isa"
+    fi
+done
+
+# v2 多用小块以得到多个块，v1 输入大于并行编码的分段阈值
+CONFIGS=(
+    "--streams 1 --block-size 64K"
+    "--streams 4 --block-size 64K"
+    "--streams 4"
+    "--legacy"
+)
+
+# 最大码长不超过 15 时 AVX2 及以上的编码内核走向量路径，否则回退到标量路径；
+# 偏斜输入在码长限制为 20 时码长超过 15，两条路径都要覆盖
+CODE_LENGTHS=(
+    ""
+    "--max-code-length 20"
+)
+
+MATRIX=()
+for config in "${CONFIGS[@]}"; do
+    for lengths in "${CODE_LENGTHS[@]}"; do
+        MATRIX+=("$config${lengths:+ $lengths}")
+    done
+done
+
+failures=0
+fail() {
+    echo "FAIL: $*"
+    failures=$((failures + 1))
+}
+
+count=0
+for kind in random skewed text; do
+    input="$WORK/$kind.bin"
+    "$GENERATOR" "$kind" "$INPUT_SIZE" "$input"
+
+    for config in "${MATRIX[@]}"; do
+        reference=""
+        for isa in "${ISAS[@]}"; do
+            for jobs in 1 "$JOBS"; do
+                count=$((count + 1))
+                name="$count"
+                archive="$WORK/$name.huff"
+                # shellcheck disable=SC2086
+                if ! "$BIN" -o "$archive" compress $config --isa "$isa" -j "$jobs" "$input" > /dev/null; then
+                    fail "$kind [$config] --isa $isa -j $jobs: 压缩失败"
+                    continue
+                fi
+
+                # 第一个组合（scalar、单线程）作为参照
+                if [ -z "$reference" ]; then
+                    reference=$archive
+                elif ! cmp -s "$reference" "$archive"; then
+                    fail "$kind [$config] --isa $isa -j $jobs: 压缩结果与 scalar -j 1 不同"
+                fi
+
+                if ! "$BIN" -o "$WORK/$name.out" extra --isa "$isa" -j "$jobs" "$archive" > /dev/null; then
+                    fail "$kind [$config] --isa $isa -j $jobs: 解压失败"
+                    continue
+                fi
+                if ! cmp -s "$input" "$WORK/$name.out/$kind.bin"; then
+                    fail "$kind [$config] --isa $isa -j $jobs: 解压结果与输入不同"
+                fi
+                rm -rf "$WORK/$name.out"
+                if [ "$archive" != "$reference" ]; then
+                    rm -f "$archive"
+                fi
+            done
+        done
+    done
+done
+
+# 以下用默认指令集覆盖矩阵之外的路径
+text="$WORK/text.bin"
+"$GENERATOR" text "$INPUT_SIZE" "$text"
+
+# 流式压缩和解压：标准输入到标准输出，输出与线程数无关
+for jobs in 1 "$JOBS"; do
+    count=$((count + 1))
+    if ! "$BIN" compress - --block-size 64K -j "$jobs" < "$text" > "$WORK/stream-$jobs.huff"; then
+        fail "流式压缩 -j $jobs: 压缩失败"
+        continue
+    fi
+    if ! cmp -s "$WORK/stream-1.huff" "$WORK/stream-$jobs.huff"; then
+        fail "流式压缩 -j $jobs: 压缩结果与 -j 1 不同"
+    fi
+    if ! "$BIN" extra - -j "$jobs" < "$WORK/stream-$jobs.huff" | cmp -s "$text" -; then
+        fail "流式压缩 -j $jobs: 从标准输入解压的结果与输入不同"
+    fi
+    if ! "$BIN" -o "$WORK/stream-$jobs.out" extra -j "$jobs" "$WORK/stream-$jobs.huff" > /dev/null \
+        || ! cmp -s "$text" "$WORK/stream-$jobs.out"; then
+        fail "流式压缩 -j $jobs: 从文件解压的结果与输入不同"
+    fi
+done
+
+# 逐位遍历树解码
+for config in "--block-size 64K" "--legacy"; do
+    count=$((count + 1))
+    archive="$WORK/tree-walk-${config// /}.huff"
+    # shellcheck disable=SC2086
+    "$BIN" -o "$archive" compress $config "$text" > /dev/null
+    if ! "$BIN" -o "$WORK/tree-walk.out" extra --tree-walk "$archive" > /dev/null \
+        || ! cmp -s "$text" "$WORK/tree-walk.out/text.bin"; then
+        fail "--tree-walk [$config]: 解压结果与输入不同"
+    fi
+    rm -rf "$WORK/tree-walk.out"
+done
+
+# v1 多线程推测解码：输入足够大，每个线程分到多段
+count=$((count + 1))
+"$GENERATOR" text $((4 * INPUT_SIZE)) "$WORK/large.bin"
+"$BIN" -o "$WORK/large.huff" compress --legacy -j "$JOBS" "$WORK/large.bin" > /dev/null
+if ! "$BIN" -o "$WORK/large.out" extra -j "$JOBS" "$WORK/large.huff" > /dev/null \
+    || ! cmp -s "$WORK/large.bin" "$WORK/large.out/large.bin"; then
+    fail "--legacy -j $JOBS: 解压结果与输入不同"
+fi
+
+# 按范围解压：带索引和不带索引的流式压缩文件、带索引的单个文件和 v1 文件，范围跨越块边界并包括末尾
+"$BIN" compress - --block-size 64K --index < "$text" > "$WORK/range-index.huff"
+"$BIN" compress - --block-size 64K < "$text" > "$WORK/range-scan.huff"
+"$BIN" -o "$WORK/range-file.huff" compress --block-size 64K --index "$text" > /dev/null
+"$BIN" -o "$WORK/range-legacy.huff" compress --legacy "$text" > /dev/null
+for archive in range-index range-scan range-file range-legacy; do
+    for range in "0 100" "65530 20" "100000 300000" "$((INPUT_SIZE - 10)) 100" "$INPUT_SIZE 1"; do
+        read -r offset length <<< "$range"
+        count=$((count + 1))
+        if ! "$BIN" extra "$WORK/$archive.huff" --range "$offset" "$length" > "$WORK/range.out"; then
+            fail "--range $range [$archive]: 解压失败"
+            continue
+        fi
+        if ! head -c $((offset + length)) "$text" | tail -c +$((offset + 1)) | cmp -s - "$WORK/range.out"; then
+            fail "--range $range [$archive]: 结果与输入的对应部分不同"
+        fi
+    done
+
+    # 起始偏移超出末尾时报错
+    count=$((count + 1))
+    if "$BIN" extra "$WORK/$archive.huff" --range $((INPUT_SIZE + 1)) 1 > /dev/null 2>&1; then
+        fail "--range [$archive]: 起始偏移超出末尾时没有报错"
+    fi
+done
+
+echo "$count 个组合，$failures 个失败"
+test "$failures" -eq 0